@@ -1,5 +1,6 @@
 #include <iomanip> // 출력 포맷 조정 위한 헤더
 #include "examples.h"
+#include "linear_algebra.h"
 
 using namespace seal;
 using namespace std;
@@ -21,6 +22,19 @@ void example_multiply_vector_matrix_dynamic()
     cout << "Enter the dimension (N) of the vector and matrix: ";
     cin >> vector_size;
 
+    // 연산 방식 선택
+    int method;
+    cout << "Select method (1: diagonal, 2: baby-step/giant-step, 3: packed rows, 4: batched clients, 5: tiled for N > slot_count / 2): ";
+    cin >> method;
+
+    // 대각선 방식은 가지치기된 가중치처럼 띠 행렬을 쓸 수 있다 (모두 0인 대각선은 건너뜀)
+    size_t band_width = 0;
+    if (method == 1)
+    {
+        cout << "Enter the band width, nonzero diagonals on each side of the main diagonal (0: dense): ";
+        cin >> band_width;
+    }
+
     // 암호화 파라미터 설정
     EncryptionParameters parms(scheme_type::ckks); // CKKS 사용
     size_t poly_modulus_degree = 8192;
@@ -37,8 +51,6 @@ void example_multiply_vector_matrix_dynamic()
     keygen.create_public_key(public_key);
     RelinKeys relin_keys;
     keygen.create_relin_keys(relin_keys);
-    GaloisKeys galois_keys;
-    keygen.create_galois_keys(galois_keys); // rotation 위한 Galois 키 생성
 
     Encryptor encryptor(context, public_key);
     Evaluator evaluator(context); // 평가 객체(동형 연산 수행)
@@ -48,30 +60,169 @@ void example_multiply_vector_matrix_dynamic()
     double scale = pow(2.0, 40);
     size_t slot_count = encoder.slot_count(); // 사용 가능한 슬롯 개수 확인
 
+    // 방식마다 N의 상한이 다르므로 행렬과 회전 키를 만들기 전에 확인
+    // (대각선, BSGS는 입력을 두 번 복제하므로 slot_count / 2, 다중 행 패킹과 배치는 slot_count)
+    size_t max_vector_size = (method == 3 || method == 4) ? slot_count : slot_count / 2;
+    if (method != 5 && (vector_size == 0 || vector_size > max_vector_size))
+    {
+        cout << "N must be between 1 and " << max_vector_size << " for this method (use method 5 for larger N)."
+             << endl;
+        return;
+    }
+
     // 입력 벡터 및 행렬 생성
+    // 타일 방식은 N이 커서 행렬을 메모리에 만들지 않고 원소 함수로 읽으며, 내적이 scale 범위를 넘지 않도록 작은 값을 쓴다
+    auto matrix_entry = [&](size_t i, size_t j) {
+        if (method == 5)
+        {
+            return static_cast<double>((i + j) % 7 + 1) / static_cast<double>(vector_size);
+        }
+        if (band_width > 0 && (i > j + band_width || j > i + band_width))
+        {
+            return 0.0;
+        }
+        return static_cast<double>((i * vector_size) + (j + 1));
+    };
     vector<double> input_vector(vector_size);
-    vector<vector<double>> matrix(vector_size, vector<double>(vector_size));
-
     for (size_t i = 0; i < vector_size; i++)
     {
         input_vector[i] = static_cast<double>(i + 1); // {1.0, 2.0, ..., N}
-        for (size_t j = 0; j < vector_size; j++)
+    }
+
+    // 띠 행렬은 조밀한 N x N 행렬을 만들지 않고 띠 안의 원소만 읽어 대각선으로 바로 저장한다
+    bool banded = method == 1 && band_width > 0;
+    vector<vector<double>> matrix;
+    if (banded)
+    {
+        print_vector("Input Vector", input_vector, vector_size);
+        cout << "Banded matrix: " << vector_size << " x " << vector_size << ", band width " << band_width << endl;
+    }
+    else if (method != 5)
+    {
+        matrix.assign(vector_size, vector<double>(vector_size));
+        for (size_t i = 0; i < vector_size; i++)
         {
-            matrix[i][j] = static_cast<double>((i * vector_size) + (j + 1)); // 행렬 값 생성
+            for (size_t j = 0; j < vector_size; j++)
+            {
+                matrix[i][j] = matrix_entry(i, j); // 행렬 값 생성
+            }
+        }
+
+        // 벡터와 행렬 출력
+        print_vector("Input Vector", input_vector, vector_size);
+        cout << "Matrix: " << endl;
+        for (const auto &row : matrix)
+        {
+            print_vector("", row, vector_size);
         }
     }
 
-    // 벡터와 행렬 출력
-    print_vector("Input Vector", input_vector, vector_size);
-    cout << "Matrix: " << endl;
-    for (const auto &row : matrix)
+    // 대각선 방식: 0이 아닌 대각선만 저장
+    DiagonalMatrix diagonal_matrix{ vector_size, {} };
+    if (method == 1)
     {
-        print_vector("", row, vector_size);
+        diagonal_matrix = banded ? make_banded_matrix(vector_size, band_width, band_width, matrix_entry)
+                                 : to_diagonal_matrix(matrix);
+        cout << "Nonzero diagonals: " << diagonal_matrix.diagonals.size() << " / " << vector_size << endl;
     }
 
-    // 입력 벡터를 CKKS 슬롯 크기에 맞게 확장
-    vector<double> input_vector_extended = input_vector;
-    input_vector_extended.resize(slot_count, 0.0); // 슬롯 크기에 맞게 확장
+    // 선택한 방식이 실제로 쓰는 회전 키만 생성
+    RotationKeyPlanner key_planner;
+    if (method == 2)
+    {
+        key_planner.add_bsgs_matvec(vector_size, poly_modulus_degree / 2);
+    }
+    else if (method == 3)
+    {
+        key_planner.add_packed_rows_matvec(vector_size, poly_modulus_degree / 2);
+    }
+    else if (method == 4)
+    {
+        key_planner.add_batched_matvec(vector_size, poly_modulus_degree / 2);
+    }
+    else if (method == 5)
+    {
+        key_planner.add_tiled_matvec(poly_modulus_degree / 2);
+    }
+    else
+    {
+        key_planner.add_sparse_matvec(diagonal_matrix);
+    }
+    GaloisKeys galois_keys;
+    key_planner.create_galois_keys(keygen, galois_keys);
+
+    if (method == 5)
+    {
+        // 벡터를 slot_count / 2 길이의 타일로 나눠 암호화하고, 행렬 블록은 곱하면서 하나씩 인코딩
+        vector<Ciphertext> encrypted_tiles;
+        encrypt_tiled_vector(encoder, encryptor, input_vector, scale, encrypted_tiles);
+        cout << "Tile size: " << choose_tile_size(slot_count) << ", tiles: " << encrypted_tiles.size() << endl;
+
+        ParallelExecutor executor;
+        vector<Ciphertext> encrypted_results;
+        auto time_start = chrono::high_resolution_clock::now();
+        multiply_matrix_vector_tiled(
+            context, evaluator, encoder, galois_keys, vector_size, vector_size, matrix_entry, encrypted_tiles,
+            encrypted_results, executor);
+        auto time_end = chrono::high_resolution_clock::now();
+        cout << "Tiled matrix-vector product done with " << executor.thread_count() << " threads ["
+             << chrono::duration_cast<chrono::microseconds>(time_end - time_start).count() << " microseconds]"
+             << endl;
+
+        // 모든 행의 최대 오차와 앞쪽 몇 행의 결과
+        vector<double> result = decrypt_tiled_vector(decryptor, encoder, encrypted_results, vector_size);
+        double max_error = 0.0;
+        for (size_t i = 0; i < vector_size; i++)
+        {
+            double expected = 0.0;
+            for (size_t j = 0; j < vector_size; j++)
+            {
+                expected += input_vector[j] * matrix_entry(i, j);
+            }
+            max_error = max(max_error, abs(result[i] - expected));
+            if (i < 8)
+            {
+                cout << "Row " << i << ": " << fixed << setprecision(6) << result[i] << " (expected " << expected
+                     << ")" << endl;
+            }
+        }
+        cout << "Max difference over all rows: " << scientific << max_error << fixed << endl;
+        return;
+    }
+
+    // 입력 벡터를 CKKS 슬롯에 배치
+    vector<double> input_vector_extended;
+    RowPacking packing{};
+    BatchLayout layout{};
+    vector<vector<double>> client_vectors;
+    if (method == 4)
+    {
+        layout = choose_batch_layout(vector_size, slot_count);
+        // 클라이언트 벡터 B개를 슬롯 j*B + b에 섞어 배치 (b번째 클라이언트는 입력 벡터에 b를 더한 값)
+        for (size_t b = 0; b < layout.batch_size; b++)
+        {
+            vector<double> client_vector = input_vector;
+            for (auto &value : client_vector)
+            {
+                value += static_cast<double>(b);
+            }
+            client_vectors.push_back(move(client_vector));
+        }
+        input_vector_extended = interleave_vectors(client_vectors, layout, slot_count);
+    }
+    else if (method == 3)
+    {
+        // 다중 행 패킹: segment 크기로 0을 채운 벡터를 슬롯 전체에 복제
+        packing = choose_row_packing(vector_size, slot_count);
+        vector<double> padded_vector = input_vector;
+        padded_vector.resize(packing.segment_size, 0.0);
+        input_vector_extended = replicate_vector(padded_vector, packing.rows_per_ciphertext, slot_count);
+    }
+    else
+    {
+        // 대각선 방식은 0 ~ N-1 회전이 순환하도록 입력 벡터를 두 번 복제
+        input_vector_extended = replicate_vector(input_vector, 2, slot_count);
+    }
 
     // 입력 벡터를 평문으로 인코딩
     Plaintext plain_vector;
@@ -81,74 +232,125 @@ void example_multiply_vector_matrix_dynamic()
     Ciphertext encrypted_vector;
     encryptor.encrypt(plain_vector, encrypted_vector);
 
-    // 결과 저장용 벡터
-    vector<Ciphertext> row_results;
+    // 고정된 가중치 행렬은 방식에 맞는 평문으로 한 번만 인코딩해 둔다 (요청마다 encode 하지 않음)
+    auto encode_start = chrono::high_resolution_clock::now();
+    WeightCache weights = (method == 4)   ? make_batched_weights(encoder, matrix)
+                          : (method == 3) ? make_packed_rows_weights(encoder, matrix)
+                          : (method == 2) ? make_bsgs_weights(encoder, matrix)
+                                          : make_sparse_diagonal_weights(encoder, diagonal_matrix);
+    weights.prepare_rescale_levels(context);
+    auto encode_end = chrono::high_resolution_clock::now();
+    cout << "Weights encoded once (" << weights.encoded_count() << " plaintexts) ["
+         << chrono::duration_cast<chrono::microseconds>(encode_end - encode_start).count() << " microseconds]"
+         << endl;
 
-    // 각 행에 대해 연산 수행
-    for (size_t i = 0; i < vector_size; i++)
+    // 슬롯 위치 -> 행 번호 대응은 방식마다 다르므로 복호화 후 decoded_result[i]에 i번째 행 결과를 모음
+    vector<double> decoded_result(vector_size);
+    Plaintext decrypted_result;
+    vector<double> decoded_slots;
+    auto time_start = chrono::high_resolution_clock::now();
+    if (method == 4)
     {
-        vector<double> row = matrix[i]; // 현재 행 추출
-        row.resize(slot_count, 0.0); // 슬롯 크기에 맞게 확장
+        // 클라이언트 B개의 행렬-벡터 곱을 암호문 하나로 한 번에 계산 (회전 step은 B의 배수)
+        cout << "Batch dimension: " << layout.dimension << ", clients per ciphertext: " << layout.batch_size << endl;
+        Ciphertext encrypted_result;
+        multiply_matrix_vector_batched(context, evaluator, galois_keys, layout, weights, encrypted_vector, encrypted_result);
+        auto time_end = chrono::high_resolution_clock::now();
+        cout << "Matrix-vector product done for " << layout.batch_size << " clients ["
+             << chrono::duration_cast<chrono::microseconds>(time_end - time_start).count() << " microseconds]"
+             << endl;
 
-        // 행을 평문으로 인코딩
-        Plaintext plain_row;
-        encoder.encode(row, scale, plain_row);
+        decryptor.decrypt(encrypted_result, decrypted_result);
+        encoder.decode(decrypted_result, decoded_slots);
+        auto client_results = deinterleave_vectors(decoded_slots, layout, layout.batch_size, vector_size);
 
-        // 행 암호화 및 곱셈
-        Ciphertext temp;
-        evaluator.multiply_plain(encrypted_vector, plain_row, temp);
-        evaluator.rescale_to_next_inplace(temp); // 곱셈 후 리스케일링
-
-        // 곱셈 결과 출력
-        Plaintext debug_plain;
-        decryptor.decrypt(temp, debug_plain);
-        vector<double> debug_result;
-        encoder.decode(debug_plain, debug_result);
-        cout << i << "번째 행 곱셈 결과: ";
-        print_vector("", debug_result, vector_size);
-
-        // 스케일 재설정
-        temp.scale() = scale;
-
-        // 회전 결과 누적 합산
-        Ciphertext sum = temp;
-        for (size_t rot = 1; rot < vector_size; rot++)
+        // 모든 클라이언트에 대한 최대 오차
+        double max_error = 0.0;
+        for (size_t b = 0; b < layout.batch_size; b++)
         {
-            Ciphertext rotated;
-            evaluator.rotate_vector(temp, rot, galois_keys, rotated); // 벡터 회전
-
-            // 회전 결과 출력
-            decryptor.decrypt(rotated, debug_plain);
-            encoder.decode(debug_plain, debug_result);
-            cout << i + 1 << " 번째 행 " << rot << " 회전 후 : ";
-            print_vector("", debug_result, vector_size);
+            for (size_t i = 0; i < vector_size; i++)
+            {
+                double expected = 0.0;
+                for (size_t j = 0; j < vector_size; j++)
+                {
+                    expected += client_vectors[b][j] * matrix[i][j];
+                }
+                max_error = max(max_error, abs(client_results[b][i] - expected));
+            }
+        }
+        cout << "Max difference over all clients: " << scientific << max_error << fixed << endl;
+        decoded_result = client_results[0];
+    }
+    else if (method == 3)
+    {
+        // 행 slot_count / segment 개를 multiply_plain 한 번 + 회전 log2(segment)번으로 계산
+        cout << "Segment size: " << packing.segment_size << ", rows per ciphertext: " << packing.rows_per_ciphertext
+             << endl;
+        // 출력 암호문마다 독립이므로 모든 코어에 나눠 계산
+        vector<Ciphertext> encrypted_results;
+        multiply_matrix_vector_packed_rows(
+            context, evaluator, galois_keys, packing, weights, encrypted_vector, encrypted_results,
+            ParallelExecutor());
+        auto time_end = chrono::high_resolution_clock::now();
+        cout << "Matrix-vector product done (" << encrypted_results.size() << " ciphertexts) ["
+             << chrono::duration_cast<chrono::microseconds>(time_end - time_start).count() << " microseconds]"
+             << endl;
 
-            evaluator.add_inplace(sum, rotated); // 누적 합산
+        for (size_t c = 0; c < encrypted_results.size(); c++)
+        {
+            decryptor.decrypt(encrypted_results[c], decrypted_result);
+            encoder.decode(decrypted_result, decoded_slots);
+            for (size_t k = 0; k < packing.rows_per_ciphertext; k++)
+            {
+                size_t row_index = c * packing.rows_per_ciphertext + k;
+                if (row_index < vector_size)
+                {
+                    decoded_result[row_index] = decoded_slots[k * packing.segment_size];
+                }
+            }
         }
+    }
+    else
+    {
+        Ciphertext encrypted_result;
+        if (method == 2)
+        {
+            // BSGS: 회전 약 2*sqrt(N)번
+            BsgsSplit split = choose_bsgs_split(vector_size, slot_count);
+            cout << "Baby steps: " << split.baby_steps << ", giant steps: " << split.giant_steps << endl;
+            multiply_matrix_vector_bsgs(context, evaluator, galois_keys, weights, encrypted_vector, encrypted_result);
+        }
+        else
+        {
+            // 0이 아닌 일반화 대각선만으로 행렬-벡터 곱 (회전, multiply_plain 모두 대각선 수만큼)
+            multiply_matrix_vector_sparse(
+                context, evaluator, galois_keys, diagonal_matrix, weights, encrypted_vector, encrypted_result);
+        }
+        auto time_end = chrono::high_resolution_clock::now();
+        cout << "Matrix-vector product done ["
+             << chrono::duration_cast<chrono::microseconds>(time_end - time_start).count() << " microseconds]"
+             << endl;
 
-        row_results.push_back(sum); // 현재 행의 회전 결과 저장
+        // 결과 복호화: 슬롯 i에 i번째 행의 내적이 들어 있음
+        decryptor.decrypt(encrypted_result, decrypted_result);
+        encoder.decode(decrypted_result, decoded_slots);
+        copy(decoded_slots.begin(), decoded_slots.begin() + static_cast<ptrdiff_t>(vector_size), decoded_result.begin());
     }
 
     // 최종 결과 출력
     cout << "\nFinal Results:" << endl;
-    for (size_t i = 0; i < row_results.size(); i++)
+    for (size_t i = 0; i < vector_size; i++)
     {
-        // 결과 복호화
-        Plaintext decrypted_result;
-        decryptor.decrypt(row_results[i], decrypted_result);
-        vector<double> decoded_result;
-        encoder.decode(decrypted_result, decoded_result); // 복호화된 값 디코딩
-
         // 기존의 출력되어야 할 내적 값 계산
         double expected = 0.0;
         for (size_t j = 0; j < vector_size; j++)
         {
-            expected += input_vector[j] * matrix[i][j];
+            expected += input_vector[j] * matrix_entry(i, j);
         }
 
         cout << "\nRow " << i << ":" << endl;
-        cout << "Derypted result (decoded): " << decoded_result[0] << setprecision(10) << endl;
+        cout << "Derypted result (decoded): " << decoded_result[i] << setprecision(10) << endl;
         cout << "Expected result: " << expected << endl;
-        cout << "Difference: " << (decoded_result[0] - expected) << endl;
+        cout << "Difference: " << (decoded_result[i] - expected) << endl;
     }
 }
@@ -1,5 +1,7 @@
 #include <iomanip>
 #include "examples.h"
+#include "linear_algebra.h"
+#include "parameter_planner.h"
 
 using namespace seal;
 using namespace std;
@@ -24,41 +26,11 @@ void example_multiply_matrix_matrix_dynamic()
     cout << "Enter the dimensions (N, M, K) for matrix multiplication (NxM) * (MxK): ";
     cin >> N >> M >> K;
 
-    // 암호화 파라미터 설정
-    EncryptionParameters parms(scheme_type::ckks);
-    size_t poly_modulus_degree = 8192; // 슬롯 크기 설정
-    parms.set_poly_modulus_degree(poly_modulus_degree);
-    parms.set_coeff_modulus(CoeffModulus::Create(poly_modulus_degree, { 60, 40, 40, 60 }));
-
-    SEALContext context(parms);
-
-    // (파라미터 유효성 검사 추가)
-    if (!context.parameters_set())
-    {
-        cout << "Invalid encryption parameters!" << endl;
-        return;
-    }
-
-    // 키 생성
-    KeyGenerator keygen(context);
-    SecretKey secret_key = keygen.secret_key();
-    PublicKey public_key;
-    keygen.create_public_key(public_key);
-    RelinKeys relin_keys;
-    keygen.create_relin_keys(relin_keys);
-
-    // GaloisKeys 생성
-    GaloisKeys galois_keys;
-    keygen.create_galois_keys(galois_keys);
-
-    Encryptor encryptor(context, public_key);
-    Evaluator evaluator(context);
-    Decryptor decryptor(context, secret_key);
-    CKKSEncoder encoder(context);
-
-    // 스케일 및 슬롯 크기 설정
-    double scale = pow(2.0, 40);
-    size_t slot_count = encoder.slot_count();
+    // 출력 블록 (i, j)를 나눠 계산할 스레드 수
+    size_t thread_count;
+    cout << "Enter the number of threads (0: all cores): ";
+    cin >> thread_count;
+    ParallelExecutor executor(thread_count);
 
     // 행렬1 (NxM) 초기화(1.0 ~ 값 채움)
     vector<vector<double>> matrix_A(N, vector<double>(M, 0.0));
@@ -80,98 +52,134 @@ void example_multiply_matrix_matrix_dynamic()
         }
     }
 
-    print_matrix("Matrix A", matrix_A);
-    print_matrix("Matrix B", matrix_B);
-
-    // 행렬 1의 각 행 암호화
-    vector<Ciphertext> encrypted_matrix_A(N);
+    // 평문 곱 (결과 비교와 첫 소수 크기에 쓴다)
+    vector<vector<double>> expected_matrix(N, vector<double>(K, 0.0));
+    double value_bound = 1.0;
     for (size_t i = 0; i < N; i++)
     {
-        vector<double> row(slot_count, 0.0);
-        copy(matrix_A[i].begin(), matrix_A[i].end(), row.begin()); // 행을 슬롯에 복사해둠
-        Plaintext plain_row;
-        encoder.encode(row, scale, plain_row);
-        encryptor.encrypt(plain_row, encrypted_matrix_A[i]); // 암호화 후 저장
-    }
-
-    // 행렬2 각 열을 암호화
-    vector<Ciphertext> encrypted_matrix_B(K);
-    for (size_t j = 0; j < K; j++)
-    {
-        vector<double> col(slot_count, 0.0);
-        for (size_t i = 0; i < M; i++)
+        for (size_t j = 0; j < K; j++)
         {
-            col[i] = matrix_B[i][j]; // 열을 슬롯에 복사
+            for (size_t k = 0; k < M; k++)
+            {
+                expected_matrix[i][j] += matrix_A[i][k] * matrix_B[k][j];
+            }
+            value_bound = max(value_bound, fabs(expected_matrix[i][j]));
         }
-        Plaintext plain_col;
-        encoder.encode(col, scale, plain_col);
-        encryptor.encrypt(plain_col, encrypted_matrix_B[j]);
     }
 
-    // Print encrypted_matrix_B for debugging
-    cout << "Encrypted Matrix B (Ciphertexts):" << endl;
-    for (size_t j = 0; j < K; j++)
+    // 암호화 파라미터 설정 (sigma/tau, phi, 암호문 곱에 레벨 3개).
+    // 결과는 첫 소수 하나에 남으므로 첫 소수는 scale + log2(결과의 최댓값) + 2비트여야 한다.
+    // 첫 소수는 60비트 이하이므로 결과가 크면 정밀도(scale)를 줄여서 맞춘다
+    CircuitSpec circuit;
+    circuit.depth = 3;
+    circuit.value_bound = value_bound;
+    circuit.precision_bits = min(20, 38 - static_cast<int>(ceil(log2(value_bound))));
+    if (circuit.precision_bits < 10)
+    {
+        cout << "결과 값이 너무 커서 60비트 첫 소수에 들어가지 않습니다." << endl;
+        return;
+    }
+    ParameterPlan plan;
+    try
     {
-        cout << "Encrypted column " << j << ": parms_id = " << encrypted_matrix_B[j].parms_id()
-             << ", size = " << encrypted_matrix_B[j].size() << endl;
+        plan = plan_parameters(circuit);
     }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits" << endl;
+    EncryptionParameters parms = plan.parameters();
+    size_t poly_modulus_degree = plan.poly_modulus_degree;
 
-    // 결과 행렬 (NxK) 초기화
-    vector<vector<double>> result_matrix(N, vector<double>(K, 0.0));
+    SEALContext context(parms);
 
-    // 행렬 곱셈 수행
-    for (size_t i = 0; i < N; i++)
+    // (파라미터 유효성 검사 추가)
+    if (!context.parameters_set())
     {
-        for (size_t j = 0; j < K; j++)
-        {
-            // 행렬1의 i번째 행과 행렬2의 j번째 열의 내적 계산
-            Ciphertext dot_product;
-            evaluator.multiply(encrypted_matrix_A[i], encrypted_matrix_B[j], dot_product);
+        cout << "Invalid encryption parameters!" << endl;
+        return;
+    }
 
-            evaluator.relinearize_inplace(dot_product, relin_keys);
-            evaluator.rescale_to_next_inplace(dot_product);
+    // 세 차원을 모두 덮는 d x d 블록 크기 (d^2 <= slot_count, Galois 키 수 제한)
+    size_t slot_count = poly_modulus_degree / 2;
+    size_t block_dimension = choose_block_dimension(N, M, K, slot_count);
+    cout << "Block dimension: " << block_dimension << ", Galois keys: " << packed_matmul_key_count(block_dimension)
+         << endl;
 
-            // rotation 및 합산
-            Ciphertext sum = dot_product;
-            for (size_t rot = 1; rot < M; rot++)
-            {
-                Ciphertext rotated;
-                evaluator.rotate_vector(dot_product, rot, galois_keys, rotated);
-                evaluator.add_inplace(sum, rotated);
-            }
+    // 키 생성
+    KeyGenerator keygen(context);
+    SecretKey secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
 
-            // 복호화 및 디코딩
-            Plaintext plain_result;
-            decryptor.decrypt(sum, plain_result);
-            vector<double> decoded_result;
-            encoder.decode(plain_result, decoded_result);
+    // GaloisKeys 생성 (sigma/tau/phi/psi 치환에 필요한 step만)
+    RotationKeyPlanner key_planner;
+    key_planner.add_packed_matmul(block_dimension);
+    GaloisKeys galois_keys;
+    key_planner.create_galois_keys(keygen, galois_keys);
 
-            // 결과 저장
-            result_matrix[i][j] = decoded_result[0];
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
 
-            // 원래 연산 값 계산
-            double expected = 0.0;
-            for (size_t k = 0; k < M; k++)
-            {
-                expected += matrix_A[i][k] * matrix_B[k][j];
-            }
+    // 스케일 설정
+    double scale = plan.scale();
 
-            // 오차 계산
-            double absolute_error = fabs(decoded_result[0] - expected);
-            double relative_error = (expected != 0.0) ? fabs(absolute_error / expected) : 0.0;
+    // 치환 마스크는 블록 크기마다 한 번만 만들고, 첫 블록 곱에서 인코딩한 평문을 모든 블록 곱이 같이 쓴다
+    PackedMatmulWeights weights = make_packed_matmul_weights(encoder, block_dimension);
+
+    print_matrix("Matrix A", matrix_A);
+    print_matrix("Matrix B", matrix_B);
+
+    // 두 행렬을 블록 단위로 패킹해서 암호화 (블록 하나당 암호문 하나)
+    EncryptedBlockMatrix encrypted_matrix_A;
+    EncryptedBlockMatrix encrypted_matrix_B;
+    encrypt_block_matrix(encoder, encryptor, matrix_A, block_dimension, scale, encrypted_matrix_A);
+    encrypt_block_matrix(encoder, encryptor, matrix_B, block_dimension, scale, encrypted_matrix_B);
+    cout << "Encrypted A: " << encrypted_matrix_A.blocks.size() << "x" << encrypted_matrix_A.blocks[0].size()
+         << " blocks, B: " << encrypted_matrix_B.blocks.size() << "x" << encrypted_matrix_B.blocks[0].size()
+         << " blocks" << endl;
+
+    // 행렬 곱셈 수행 (출력 블록마다 스레드 하나, 스레드마다 전용 메모리 풀)
+    EncryptedBlockMatrix encrypted_result;
+    auto time_start = chrono::high_resolution_clock::now();
+    multiply_block_matrices(
+        context, evaluator, relin_keys, galois_keys, weights, encrypted_matrix_A, encrypted_matrix_B,
+        encrypted_result, executor);
+    auto time_end = chrono::high_resolution_clock::now();
+    cout << "Matrix product done with " << executor.thread_count() << " threads ["
+         << chrono::duration_cast<chrono::microseconds>(time_end - time_start).count() << " microseconds]" << endl;
+
+    // 블록 단위로 복호화 및 디코딩
+    vector<vector<double>> result_matrix = decrypt_block_matrix(decryptor, encoder, encrypted_result);
+
+    double max_error = 0.0;
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t j = 0; j < K; j++)
+        {
+            // 원래 연산 값과 오차
+            double expected = expected_matrix[i][j];
+            double absolute_error = fabs(result_matrix[i][j] - expected);
+            max_error = max(max_error, absolute_error);
 
             // 결과 출력
             cout << fixed << setprecision(20);
             cout << "Result[" << i << "][" << j << "]:" << endl;
-            cout << "  Encrypted result (decoded): " << decoded_result[0] << endl;
+            cout << "  Encrypted result (decoded): " << result_matrix[i][j] << endl;
             cout << "  Expected result: " << expected << endl;
             cout << "  오차: " << absolute_error << endl;
-            
         }
     }
 
-
     // 최종 결과 행렬 출력
     cout << "--------------------------" << endl;
     print_matrix("Result Matrix (A * B)", result_matrix);
+    cout << "최대 오차: " << max_error << " (결과 최댓값 " << value_bound << ")" << endl;
 }
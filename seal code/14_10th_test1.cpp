@@ -1,4 +1,5 @@
 #include "examples.h"
+#include "scale_manager.h"
 
 using namespace std;
 using namespace seal;
@@ -54,10 +55,8 @@ void evaluate_polynomial()
 
     cout << "Evaluating polynomial PI*x^4 + 0.4*x^2 + 1 ..." << endl;
 
-    Plaintext plain_coeff_pi, plain_coeff_04, plain_coeff1;
-    encoder.encode(3.14159265, scale, plain_coeff_pi);
-    encoder.encode(0.4, scale, plain_coeff_04);
-    encoder.encode(1.0, scale, plain_coeff1);
+    // 계수 평문의 scale은 ScaleManager가 곱할 암호문의 실제 scale에 맞춰 정한다
+    ScaleManager scales(context, evaluator, encoder);
 
     Plaintext x_plain;
     print_line(__LINE__);
@@ -92,47 +91,27 @@ void evaluate_polynomial()
     //추가
     cout << "    + Scale of x^4 after rescale: " << log2(x4_encrypted.scale()) << " bits" << endl;
 
-    // 항1: PI * x^4
+    // 항1: PI * x^4. 두 항 모두 x^4 다음 레벨, 정확히 scale이 되도록 계수 평문의 scale을 정한다
     print_line(__LINE__);
-    cout << "LOG TEST1" << endl;
     cout << "Compute and rescale PI * x^4." << endl;
-    cout << "LOG TEST2" << endl;
+    parms_id_type last_parms_id = scales.parms_id_at(scales.chain_index(x4_encrypted.parms_id()) - 1);
     Ciphertext term1;
-    cout << "LOG TEST3" << endl;
-    //+
-    evaluator.mod_switch_to_inplace(plain_coeff_pi, x4_encrypted.parms_id());
-    evaluator.multiply_plain(x4_encrypted, plain_coeff_pi, term1);
-    cout << "    + Scale of PI*x^4 before rescale: " << log2(term1.scale()) << " bits" << endl;
-    evaluator.rescale_to_next_inplace(term1);
+    scales.multiply_const(x4_encrypted, 3.14159265, last_parms_id, scale, term1);
     cout << "    + Scale of PI*x^4 after rescale: " << log2(term1.scale()) << " bits" << endl;
-    cout << "[parms_id] 항1: PI * x^4 plain_coeff_pi : "
-         << context.get_context_data(plain_coeff_pi.parms_id())->chain_index() << endl;
-    cout << "[parms_id] 항1: PI * x^4 x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-    // 항2: 0.4 * x^2
+    cout << "[parms_id] 항1: PI * x^4 : " << context.get_context_data(term1.parms_id())->chain_index() << endl;
+
+    // 항2: 0.4 * x^2 (x^2를 x^4와 같은 레벨로 내린 뒤 곱한다)
     print_line(__LINE__);
     cout << "Compute and rescale 0.4 * x^2." << endl;
     Ciphertext term2;
-    evaluator.mod_switch_to_inplace(plain_coeff_04, x2_encrypted.parms_id());
-    evaluator.multiply_plain(x2_encrypted, plain_coeff_04, term2);
-    cout << "    + Scale of 0.4*x^2 before rescale: " << log2(term2.scale()) << " bits" << endl;
-    evaluator.rescale_to_next_inplace(term2);
+    scales.multiply_const(x2_encrypted, 0.4, last_parms_id, scale, term2);
     cout << "    + Scale of 0.4*x^2 after rescale: " << log2(term2.scale()) << " bits" << endl;
 
-    print_line(__LINE__);
-    cout << "Normalize scales and encryption parameters." << endl;
-    term1.scale() = pow(2.0, 40);
-    term2.scale() = pow(2.0, 40);
-    plain_coeff1.scale() = pow(2.0, 40);
-
-    parms_id_type last_parms_id = term1.parms_id();
-    evaluator.mod_switch_to_inplace(term2, last_parms_id);
-    evaluator.mod_switch_to_inplace(plain_coeff1, last_parms_id);
-
     print_line(__LINE__);
     cout << "Compute PI*x^4 + 0.4*x^2 + 1." << endl;
     Ciphertext encrypted_result;
     evaluator.add(term1, term2, encrypted_result);
-    evaluator.add_plain_inplace(encrypted_result, plain_coeff1);
+    scales.add_const_inplace(encrypted_result, 1.0);
 
     Plaintext plain_result;
     print_line(__LINE__);
@@ -1,4 +1,5 @@
 ﻿#include "examples.h"
+#include "scale_manager.h"
 
 using namespace std;
 using namespace seal;
@@ -86,35 +87,24 @@ void evaluate_polynomial_4th()
     cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
 
 
-    // Encode constant 1
-    Plaintext plain_coeff1;
-    encoder.encode(1.0, scale, plain_coeff1);
-
-    // Align encryption parameters
-    parms_id_type last_parms_id = x4_encrypted.parms_id();
-    evaluator.mod_switch_to_inplace(x_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x2_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x3_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(plain_coeff1, last_parms_id);
-    cout << "last_parms_id = x4_encrypted" << endl;
-    cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x2_encrypted : " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x3_encrypted : " << context.get_context_data(x3_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-
-
-    // Ensure scale consistency
-    x_encrypted.scale() = pow(2.0, 40);
-    x2_encrypted.scale() = pow(2.0, 40);
-    x3_encrypted.scale() = pow(2.0, 40);
-    x4_encrypted.scale() = pow(2.0, 40);
+    // x^3과 x^4는 같은 레벨이지만 scale이 다르다 (s * s2 / q와 s2^2 / q).
+    // scale을 덮어쓰지 않고, 각 항에 계수 1을 곱하면서 다음 레벨에서 정확히 scale이 되도록 평문 scale을 정한다
+    ScaleManager scales(context, evaluator, encoder);
+    parms_id_type last_parms_id = scales.parms_id_at(scales.chain_index(x4_encrypted.parms_id()) - 1);
+    Ciphertext term1, term2, term3, term4;
+    scales.multiply_const(x_encrypted, 1.0, last_parms_id, scale, term1);
+    scales.multiply_const(x2_encrypted, 1.0, last_parms_id, scale, term2);
+    scales.multiply_const(x3_encrypted, 1.0, last_parms_id, scale, term3);
+    scales.multiply_const(x4_encrypted, 1.0, last_parms_id, scale, term4);
+    cout << "[parms_id] terms : " << context.get_context_data(last_parms_id)->chain_index() << endl;
+    cout << "[Scale] terms : " << log2(term4.scale()) << " bits" << endl;
 
     // Compute 1 + x + x^2 + x^3 + x^4
     Ciphertext encrypted_result;
-    evaluator.add(x_encrypted, x2_encrypted, encrypted_result);
-    evaluator.add_inplace(encrypted_result, x3_encrypted);
-    evaluator.add_inplace(encrypted_result, x4_encrypted);
-    evaluator.add_plain_inplace(encrypted_result, plain_coeff1);
+    evaluator.add(term1, term2, encrypted_result);
+    evaluator.add_inplace(encrypted_result, term3);
+    evaluator.add_inplace(encrypted_result, term4);
+    scales.add_const_inplace(encrypted_result, 1.0);
 
     Plaintext plain_result;
     decryptor.decrypt(encrypted_result, plain_result);
@@ -1,4 +1,5 @@
 #include "examples.h"
+#include "aligned_evaluator.h"
 
 using namespace std;
 using namespace seal;
@@ -53,122 +54,25 @@ void evaluate_polynomial_10th()
     Ciphertext x2_encrypted, x3_encrypted, x4_encrypted, x5_encrypted, x6_encrypted, x7_encrypted, x8_encrypted,
         x9_encrypted, x10_encrypted;
 
-    // 2------------------------------------------------------------------------------------------
-    evaluator.square(x_encrypted, x2_encrypted);
-    evaluator.relinearize_inplace(x2_encrypted, relin_keys);
-    
-    evaluator.rescale_to_next_inplace(x2_encrypted);
-    cout << "-----------------------------< x2 ok >-----------------------------" << endl;
-    cout << "[Scale] x2_encrypted : " << log2(x2_encrypted.scale()) << " bits" << endl;
-    cout << "[Scale] x1_encrypted : " << log2(x_encrypted.scale()) << " bits" << endl;
+    // 레벨이 다른 두 암호문을 곱할 때 AlignedEvaluator가 곱하기 직전에 높은 쪽의 복사본만 내린다.
+    // x_encrypted 등 원본은 높은 레벨 그대로 남으므로 mod_switch_to_inplace를 손으로 이어 붙일 필요가 없다.
+    AlignedEvaluator aligned(context, evaluator, encoder, relin_keys);
+
+    // 2~10------------------------------------------------------------------------------------
+    aligned.multiply(x_encrypted, x_encrypted, x2_encrypted);
+    aligned.multiply(x_encrypted, x2_encrypted, x3_encrypted);
+    aligned.multiply(x2_encrypted, x2_encrypted, x4_encrypted);
+    aligned.multiply(x_encrypted, x4_encrypted, x5_encrypted);
+    aligned.multiply(x3_encrypted, x3_encrypted, x6_encrypted);
+    aligned.multiply(x_encrypted, x6_encrypted, x7_encrypted);
+    aligned.multiply(x4_encrypted, x4_encrypted, x8_encrypted);
+    aligned.multiply(x_encrypted, x8_encrypted, x9_encrypted);
+    aligned.multiply(x5_encrypted, x5_encrypted, x10_encrypted);
+    cout << "-----------------------------< x2 ~ x10 ok >-----------------------------" << endl;
+    cout << "mod switch: " << aligned.mod_switch_count() << " (내린 레벨 " << aligned.dropped_levels() << ")" << endl;
     cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x2_encrypted : " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
+    cout << "[parms_id] x10_encrypted : " << context.get_context_data(x10_encrypted.parms_id())->chain_index() << endl;
 
-    evaluator.mod_switch_to_inplace(x_encrypted, x2_encrypted.parms_id());
-    cout << "---after mod_switch_to_inplace---" << endl;
-    cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x2_encrypted : " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
-
-    // 3------------------------------------------------------------------------------------------
-    evaluator.multiply(x_encrypted, x2_encrypted, x3_encrypted);
-    evaluator.relinearize_inplace(x3_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x3_encrypted);
-    cout << "-----------------------------< x3 ok >-----------------------------" << endl;
-    cout << "[Scale] x2_encrypted : " << log2(x3_encrypted.scale()) << " bits" << endl;
-    cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x2_encrypted : " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x3_encrypted : " << context.get_context_data(x3_encrypted.parms_id())->chain_index() << endl;
-    // evaluator.mod_switch_to_inplace(x2_encrypted, x4_encrypted.parms_id());
-    cout << "---after mod_switch_to_inplace---" << endl;
-    cout << "[parms_id] x2_encrypted : " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
-
-    // 4------------------------------------------------------------------------------------------
-    evaluator.square(x2_encrypted, x4_encrypted); // 그저 2제곱이므로 mod_switch 안함
-    evaluator.relinearize_inplace(x4_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x4_encrypted);
-    cout << "-----------------------------< x4 ok >-----------------------------" << endl;
-    cout << "[Scale] x4_encrypted : " << log2(x4_encrypted.scale()) << " bits" << endl;
-    cout << "[parms_id] x2_encrypted : " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-    evaluator.mod_switch_to_inplace(x_encrypted, x4_encrypted.parms_id());
-    cout << "---after mod_switch_to_inplace---" << endl;
-    cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-
-    // 5------------------------------------------------------------------------------------------
-    // evaluator.mod_switch_to_inplace(x4_encrypted, x_encrypted.parms_id());
-    // cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    // cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-
-    evaluator.multiply(x_encrypted, x4_encrypted, x5_encrypted);
-    evaluator.relinearize_inplace(x5_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x5_encrypted);
-    cout << "-----------------------------< x5 ok >-----------------------------" << endl;
-    cout << "[Scale] x5_encrypted : " << log2(x5_encrypted.scale()) << " bits" << endl;
-    cout << "[parms_id] x3_encrypted : " << context.get_context_data(x3_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x5_encrypted : " << context.get_context_data(x5_encrypted.parms_id())->chain_index() << endl;
-    // evaluator.mod_switch_to_inplace(x_encrypted, x4_encrypted.parms_id());
-    // cout << "---after mod_switch_to_inplace---" << endl;
-    // cout << "[parms_id] x5_encrypted : " << context.get_context_data(x5_encrypted.parms_id())->chain_index() << endl;
-
-    // 6------------------------------------------------------------------------------------------
-    evaluator.square(x3_encrypted, x6_encrypted);
-    evaluator.relinearize_inplace(x6_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x6_encrypted);
-    cout << "-----------------------------< x6 ok >-----------------------------" << endl;
-    cout << "[Scale] x6_encrypted : " << log2(x6_encrypted.scale()) << " bits" << endl;
-    cout << "[parms_id] x4_encrypted : " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x5_encrypted : " << context.get_context_data(x5_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x6_encrypted : " << context.get_context_data(x6_encrypted.parms_id())->chain_index() << endl;
-    evaluator.mod_switch_to_inplace(x3_encrypted, x6_encrypted.parms_id());
-    cout << "---after mod_switch_to_inplace---" << endl;
-    cout << "[parms_id] x6_encrypted : " << context.get_context_data(x6_encrypted.parms_id())->chain_index() << endl;
-
-    // 7------------------------------------------------------------------------------------------
-    evaluator.mod_switch_to_inplace(x_encrypted, x6_encrypted.parms_id());
-    cout << "---after mod_switch_to_inplace---" << endl;
-    cout << "[parms_id] x7_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x7_encrypted : " << context.get_context_data(x6_encrypted.parms_id())->chain_index() << endl;
-
-    evaluator.multiply(x_encrypted, x6_encrypted, x7_encrypted);
-    evaluator.relinearize_inplace(x7_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x7_encrypted);
-    cout << "-----------------------------< x7 ok >-----------------------------" << endl;
-    cout << "[Scale] x7_encrypted : " << log2(x5_encrypted.scale()) << " bits" << endl;
-    cout << "[parms_id] x6_encrypted : " << context.get_context_data(x6_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x7_encrypted : " << context.get_context_data(x7_encrypted.parms_id())->chain_index() << endl;
-
-    // 8------------------------------------------------------------------------------------------
-    evaluator.square(x4_encrypted, x8_encrypted);
-    evaluator.relinearize_inplace(x8_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x8_encrypted);
-    cout << "-----------------------------< x8 ok >-----------------------------" << endl;
-
-    // evaluator.mod_switch_to_inplace(x4_encrypted, x8_encrypted.parms_id());
-
-    // 9------------------------------------------------------------------------------------------
-    evaluator.mod_switch_to_inplace(x_encrypted, x8_encrypted.parms_id());
-    cout << "[parms_id] x_encrypted : " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] x8_encrypted : " << context.get_context_data(x8_encrypted.parms_id())->chain_index() << endl;
-
-    evaluator.multiply(x_encrypted, x8_encrypted, x9_encrypted);
-    evaluator.relinearize_inplace(x9_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x9_encrypted);
-    cout << "-----------------------------< x9 ok >-----------------------------" << endl;
-
-    cout << "[parms_id] x9_encrypted : " << context.get_context_data(x9_encrypted.parms_id())->chain_index() << endl;
-
-    // 10-----------------------------------------------------------------------------------------
-
-    evaluator.square(x5_encrypted, x10_encrypted);
-    evaluator.relinearize_inplace(x10_encrypted, relin_keys);
-    evaluator.rescale_to_next_inplace(x10_encrypted);
-    cout << "-----------------------------< x10 ok >-----------------------------" << endl;
-
-    // Plaintext plain_coeff1;
-    // encoder.encode(1.0, scale, plain_coeff1);
-    vector<Plaintext> plain_coeffs(11); // 11개의 Plaintext 저장할 벡터
     vector<double> user_inputs(11); // 사용자 입력값 저장
 
     // 사용자 입력 받기
@@ -178,107 +82,69 @@ void evaluate_polynomial_10th()
         cin >> user_inputs[i];
     }
 
-    // 입력된 값을 인코딩하여 Plaintext에 저장
-    for (int i = 0; i < 11; i++)
-    {
-        encoder.encode(user_inputs[i], scale, plain_coeffs[i]);
-    }
-
-    cout << "숫자 계수 Encoding completed." << endl;
-
+    // x^i마다 scale이 다르므로 (rescale할 때마다 2^40이 아닌 소수로 나눔) scale을 덮어쓰지 않고,
+    // 계수 평문을 (scale * 마지막 소수) / x^i.scale로 인코딩해서 모든 항의 scale을 정확히 같게 만든다
+    const ScaleManager &scales = aligned.scales();
+    vector<const Ciphertext *> powers = { nullptr,       &x_encrypted,  &x2_encrypted, &x3_encrypted,
+                                          &x4_encrypted, &x5_encrypted, &x6_encrypted, &x7_encrypted,
+                                          &x8_encrypted, &x9_encrypted, &x10_encrypted };
     parms_id_type last_parms_id = x10_encrypted.parms_id();
-    evaluator.mod_switch_to_inplace(x_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x2_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x3_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x4_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x5_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x6_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x7_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x8_encrypted, last_parms_id);
-    evaluator.mod_switch_to_inplace(x9_encrypted, last_parms_id);
-    // evaluator.mod_switch_to_inplace(plain_coeff1, last_parms_id);
+    double product_scale = scale * scales.rescale_prime(last_parms_id);
 
-    for (int i = 0; i < 11; i++)
+    Ciphertext encrypted_result;
+    Ciphertext term;
+    bool first = true;
+    for (int i = 1; i < 11; i++)
     {
-        evaluator.mod_switch_to_inplace(plain_coeffs[i], last_parms_id);
-        cout << "계수 [parms_id] " << context.get_context_data(plain_coeffs[i].parms_id())->chain_index() << endl;
+        if (user_inputs[i] == 0.0)
+        {
+            continue;
+        }
+        scales.multiply_const_to_scale(*powers[i], user_inputs[i], last_parms_id, product_scale, term);
+        cout << "[Scale] x" << i << " : " << log2(powers[i]->scale()) << " bits -> term : " << log2(term.scale())
+             << " bits" << endl;
+        if (first)
+        {
+            encrypted_result = term;
+            first = false;
+        }
+        else
+        {
+            evaluator.add_inplace(encrypted_result, term);
+        }
     }
-    cout << "-----------------------------< 레벨맞추기 ok >-----------------------------" << endl;
-
-    cout << "[parms_id] " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x2_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x3_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x4_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x5_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x6_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x7_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x8_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x9_encrypted.parms_id())->chain_index() << endl;
-    cout << "[parms_id] " << context.get_context_data(x10_encrypted.parms_id())->chain_index() << endl;
-    // cout << "[parms_id] " << context.get_context_data(plain_coeff1.parms_id())->chain_index() << endl;
-
-    x_encrypted.scale() = pow(2.0, 40);
-    x2_encrypted.scale() = pow(2.0, 40);
-    x3_encrypted.scale() = pow(2.0, 40);
-    x4_encrypted.scale() = pow(2.0, 40);
-    x5_encrypted.scale() = pow(2.0, 40);
-    x6_encrypted.scale() = pow(2.0, 40);
-    x7_encrypted.scale() = pow(2.0, 40);
-    x8_encrypted.scale() = pow(2.0, 40);
-    x9_encrypted.scale() = pow(2.0, 40);
-    x10_encrypted.scale() = pow(2.0, 40);
-    // plain_coeff1.scale() = pow(2.0, 40);
-    for (int i = 0; i < 11; i++)
+    if (first)
     {
-        plain_coeffs[i].scale() = pow(2.0, 40);
+        cout << "At least one of plain_coeff1 ~ plain_coeff10 must be nonzero." << endl;
+        return;
     }
-
-    evaluator.multiply_plain_inplace(x_encrypted, plain_coeffs[1]);
-    evaluator.multiply_plain_inplace(x2_encrypted, plain_coeffs[2]);
-    evaluator.multiply_plain_inplace(x3_encrypted, plain_coeffs[3]);
-    evaluator.multiply_plain_inplace(x4_encrypted, plain_coeffs[4]);
-    evaluator.multiply_plain_inplace(x5_encrypted, plain_coeffs[5]);
-    evaluator.multiply_plain_inplace(x6_encrypted, plain_coeffs[6]);
-    evaluator.multiply_plain_inplace(x7_encrypted, plain_coeffs[7]);
-    evaluator.multiply_plain_inplace(x8_encrypted, plain_coeffs[8]);
-    evaluator.multiply_plain_inplace(x9_encrypted, plain_coeffs[9]);
-    evaluator.multiply_plain_inplace(x10_encrypted, plain_coeffs[10]);
-    cout << "plain_coeffs[1] 곱한거 잘 되긴 함" << endl;
-    cout << "[x parms_id] " << context.get_context_data(x_encrypted.parms_id())->chain_index() << endl;
-    cout << "[Scale] x_encrypted : " << log2(x_encrypted.scale()) << " bits" << endl;
-    cout << "[Scale] x2_encrypted : " << log2(x2_encrypted.scale()) << " bits" << endl;
-    cout << "[Scale] plain_coeffs[0] : " << log2(plain_coeffs[0].scale()) << " bits" << endl;
-    x_encrypted.scale() = pow(2.0, 40);
-    x2_encrypted.scale() = pow(2.0, 40);
-    x3_encrypted.scale() = pow(2.0, 40);
-    x4_encrypted.scale() = pow(2.0, 40);
-    x5_encrypted.scale() = pow(2.0, 40);
-    x6_encrypted.scale() = pow(2.0, 40);
-    x7_encrypted.scale() = pow(2.0, 40);
-    x8_encrypted.scale() = pow(2.0, 40);
-    x9_encrypted.scale() = pow(2.0, 40);
-    x10_encrypted.scale() = pow(2.0, 40);
-
-    Ciphertext encrypted_result;
-    evaluator.add(x_encrypted, x2_encrypted, encrypted_result);
-    cout << "evaluator.add(x_encrypted, x2_encrypted, encrypted_result);" << endl;
-    evaluator.add_inplace(encrypted_result, x3_encrypted);
-    evaluator.add_inplace(encrypted_result, x4_encrypted);
-    evaluator.add_inplace(encrypted_result, x5_encrypted);
-    evaluator.add_inplace(encrypted_result, x6_encrypted);
-    evaluator.add_inplace(encrypted_result, x7_encrypted);
-    cout << "evaluator.add_inplace(encrypted_result, x7_encrypted);" << endl;
-    evaluator.add_inplace(encrypted_result, x8_encrypted);
-    evaluator.add_inplace(encrypted_result, x9_encrypted);
-    evaluator.add_inplace(encrypted_result, x10_encrypted);
-    evaluator.add_plain_inplace(encrypted_result, plain_coeffs[0]);
+    if (user_inputs[0] != 0.0)
+    {
+        scales.add_const_inplace(encrypted_result, user_inputs[0]);
+    }
+    scales.rescale_to_inplace(encrypted_result, scale);
     cout << "-----------------------------< 더하기 ok >-----------------------------" << endl;
+    cout << "[parms_id] " << context.get_context_data(encrypted_result.parms_id())->chain_index() << endl;
+    cout << "[Scale] encrypted_result : " << log2(encrypted_result.scale()) << " bits" << endl;
 
     Plaintext plain_result;
     decryptor.decrypt(encrypted_result, plain_result);
     vector<double> result;
     encoder.decode(plain_result, result);
 
+    cout << "Expected result:" << endl;
+    vector<double> true_result;
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        double value = 0.0;
+        for (int k = 10; k >= 0; k--)
+        {
+            value = value * input[i] + user_inputs[k];
+        }
+        true_result.push_back(value);
+    }
+    print_vector(true_result, 3, 7);
+
     cout << "Computed result:" << endl;
     print_vector(result, 3, 7);
 }
@@ -1,4 +1,5 @@
 #include "examples.h"
+#include "polynomial.h"
 
 using namespace std;
 using namespace seal;
@@ -7,10 +8,43 @@ void evaluate_polynomial_17()
 {
     print_example_banner("Example: CKKS Polynomial Evaluation");
 
-    size_t poly_modulus_degree = 32768;
+    int degree;
+    cout << "몇 차 다항식을 평가하겠습니까? ";
+    cin >> degree;
+    if (degree < 1)
+    {
+        cout << "Degree must be at least 1." << endl;
+        return;
+    }
+
+    // 2: 시그모이드를 [a, b]에서 Chebyshev 기저로 근사 (넓은 구간에서도 계수가 커지지 않음)
+    int basis;
+    cout << "Basis (1: monomial coefficients, 2: Chebyshev approximation of sigmoid on [a, b]): ";
+    cin >> basis;
+    double interval_a = 0.0;
+    double interval_b = 1.0;
+    if (basis == 2)
+    {
+        cout << "Enter the interval a b: ";
+        cin >> interval_a >> interval_b;
+        if (!(interval_a < interval_b))
+        {
+            cout << "a must be less than b." << endl;
+            return;
+        }
+    }
+
+    // 거듭제곱 트리 깊이 ceil(log2 d) + 계수 곱 1 (+ Chebyshev 구간 변환 1) 만큼의 40비트 소수만 사용
+    // 전체 비트 수가 16384의 한도 안이면 더 작은 링을 쓴다
+    size_t depth = polynomial_depth(static_cast<size_t>(degree)) + (basis == 2 ? 1 : 0);
+    vector<int> bit_sizes(depth + 2, 40);
+    bit_sizes.front() = 60;
+    bit_sizes.back() = 60;
+    int total_bits = 120 + 40 * static_cast<int>(depth);
+    size_t poly_modulus_degree = (total_bits <= CoeffModulus::MaxBitCount(16384)) ? 16384 : 32768;
     EncryptionParameters parms(scheme_type::ckks);
     parms.set_poly_modulus_degree(poly_modulus_degree);
-    parms.set_coeff_modulus(CoeffModulus::Create(poly_modulus_degree, { 60, 40, 40, 40, 40, 40, 60 }));
+    parms.set_coeff_modulus(CoeffModulus::Create(poly_modulus_degree, bit_sizes));
 
     double scale = pow(2.0, 40);
     SEALContext context(parms);
@@ -32,29 +66,29 @@ void evaluate_polynomial_17()
     cout << "Number of slots: " << slot_count << endl;
 
     vector<double> input(slot_count);
-    double step_size = 1.0 / (static_cast<double>(slot_count) - 1);
+    double step_size = (interval_b - interval_a) / (static_cast<double>(slot_count) - 1);
     for (size_t i = 0; i < slot_count; i++)
     {
-        input[i] = i * step_size;
+        input[i] = interval_a + i * step_size;
     }
     cout << "Input vector: " << endl;
     print_vector(input, 3, 7);
 
-    int degree;
-    cout << "몇 차 다항식을 평가하겠습니까? ";
-    cin >> degree;
-
-    vector<Plaintext> plain_coeffs(degree + 1);
+    auto sigmoid = [](double t) { return 1.0 / (1.0 + exp(-t)); };
     vector<double> user_inputs(degree + 1);
-
-    for (int i = 0; i <= degree; i++)
+    if (basis == 2)
     {
-        cout << "Enter coefficient for x^" << i << ": ";
-        cin >> user_inputs[i];
-        encoder.encode(vector<double>(slot_count, user_inputs[i]), scale, plain_coeffs[i]);
+        // Chebyshev 계수는 평문으로 미리 계산
+        user_inputs = chebyshev_coefficients(sigmoid, static_cast<size_t>(degree), interval_a, interval_b);
+    }
+    else
+    {
+        for (int i = 0; i <= degree; i++)
+        {
+            cout << "Enter coefficient for x^" << i << ": ";
+            cin >> user_inputs[i];
+        }
     }
-
-    cout << "Coefficients encoded successfully." << endl;
 
     Plaintext x_plain;
     encoder.encode(input, scale, x_plain);
@@ -62,33 +96,19 @@ void evaluate_polynomial_17()
     encryptor.encrypt(x_plain, x_encrypted);
     cout << "x encrypted successfully." << endl;
 
-    vector<Ciphertext> x_powers(degree + 1);
-    Plaintext one_plain;
-    encoder.encode(vector<double>(slot_count, 1.0), scale, one_plain);
-    encryptor.encrypt(one_plain, x_powers[0]);
-    x_powers[1] = x_encrypted;
-
-    for (int i = 2; i <= degree; i++)
-    {
-        evaluator.multiply(x_powers[i - 1], x_encrypted, x_powers[i]);
-        evaluator.relinearize_inplace(x_powers[i], relin_keys);
-        evaluator.rescale_to_next_inplace(x_powers[i]);
-    }
-
-    for (int i = 0; i <= degree; i++)
+    // x^1 ~ x^d를 ceil(log2 d) 레벨 안에 만들고, 레벨/scale을 맞춰 계수를 곱해 더한다
+    PolynomialEvaluator polynomial_evaluator(context, evaluator, encoder, relin_keys);
+    Ciphertext encrypted_result;
+    if (basis == 2)
     {
-        evaluator.mod_switch_to_inplace(plain_coeffs[i], x_powers[degree].parms_id());
+        polynomial_evaluator.evaluate_chebyshev(x_encrypted, user_inputs, interval_a, interval_b, encrypted_result);
     }
-
-    Ciphertext encrypted_result;
-    encryptor.encrypt(plain_coeffs[0], encrypted_result);
-
-    for (int i = 1; i <= degree; i++)
+    else
     {
-        Ciphertext term;
-        evaluator.multiply_plain(x_powers[i], plain_coeffs[i], term);
-        evaluator.add_inplace(encrypted_result, term);
+        polynomial_evaluator.evaluate(x_encrypted, user_inputs, encrypted_result);
     }
+    cout << "Levels used: " << depth << ", result chain index: "
+         << context.get_context_data(encrypted_result.parms_id())->chain_index() << endl;
 
     cout << "Polynomial evaluation completed." << endl;
 
@@ -99,4 +119,27 @@ void evaluate_polynomial_17()
 
     cout << "Computed result:" << endl;
     print_vector(result, 3, 7);
+
+    vector<double> expected(slot_count);
+    double max_error = 0.0;
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (basis == 2)
+        {
+            expected[i] = sigmoid(input[i]);
+        }
+        else
+        {
+            double power = 1.0;
+            for (int k = 0; k <= degree; k++)
+            {
+                expected[i] += user_inputs[k] * power;
+                power *= input[i];
+            }
+        }
+        max_error = max(max_error, fabs(result[i] - expected[i]));
+    }
+    cout << "Expected result:" << endl;
+    print_vector(expected, 3, 7);
+    cout << "Max error: " << max_error << endl;
 }
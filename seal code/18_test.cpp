@@ -2,6 +2,8 @@
 // Licensed under the MIT license.
 
 #include "examples.h"
+#include "parameter_planner.h"
+#include "polynomial.h"
 
 using namespace std;
 using namespace seal;
@@ -10,65 +12,6 @@ void evaluate_polynomial_18()
 {
     print_example_banner("Example: CKKS Automated Polynomial Evaluation");
 
-    size_t poly_modulus_degree = 32768; // 65536; // 32768;
-
-    EncryptionParameters parms(scheme_type::ckks);
-
-    parms.set_poly_modulus_degree(poly_modulus_degree);
-
-    parms.set_coeff_modulus(
-
-        CoeffModulus::Create(poly_modulus_degree, { 60, 40, 40, 40, 40, 40, 40, 40, 40, 40, 40, 40, 40,
-                                                    40, 40, 40, 40, 60 }));
-
-    double scale = pow(2.0, 40);
-
-    SEALContext context(parms);
-
-    print_parameters(context);
-
-    cout << endl;
-
-    KeyGenerator keygen(context);
-
-    auto secret_key = keygen.secret_key();
-
-    PublicKey public_key;
-
-    keygen.create_public_key(public_key);
-
-    RelinKeys relin_keys;
-
-    keygen.create_relin_keys(relin_keys);
-
-    Encryptor encryptor(context, public_key);
-
-    Evaluator evaluator(context);
-
-    Decryptor decryptor(context, secret_key);
-
-    CKKSEncoder encoder(context);
-
-    size_t slot_count = encoder.slot_count();
-
-    cout << "Number of slots: " << slot_count << endl;
-
-    vector<double> input(slot_count);
-
-    double step_size = 1.0 / (static_cast<double>(slot_count) - 1);
-
-    for (size_t i = 0; i < slot_count; i++)
-
-    {
-        input[i] = i * step_size;
-    }
-
-    cout << "Input vector: " << endl;
-
-    print_vector(input, 3, 7);
-
-    // 사용자로부터 다항식의 차수를 입력받음
-
     int degree;
 
     cout << "몇 차 다항식을 평가할래?: ";
@@ -76,144 +19,130 @@ void evaluate_polynomial_18()
     cin >> degree;
 
     if (degree < 1)
-
     {
         cout << "차수는 1 이상이어야 합니다." << endl;
-
         return;
     }
 
-    // 암호화된 x^1부터 x^degree까지 저장할 벡터
-
-    vector<Ciphertext> x_encrypted(degree + 1);
-
-    Plaintext x_plain;
-
-    encoder.encode(input, scale, x_plain);
+    vector<double> user_inputs(degree + 1);
 
-    encryptor.encrypt(x_plain, x_encrypted[1]); // x^1 암호화
+    for (int i = 0; i <= degree; i++)
+    {
+        cout << "Enter value for plain_coeff" << i << ": ";
+        cin >> user_inputs[i];
+    }
 
-    cout << "x ok" << endl;
+    // Paterson-Stockmeyer: 암호문 곱셈 약 2*sqrt(d)번, baby/giant step 거듭제곱만 메모리에 둔다
+    PatersonStockmeyerSplit split = choose_paterson_stockmeyer(static_cast<size_t>(degree));
 
-    // x^2부터 x^degree까지 계산
+    cout << "baby steps: " << split.baby_steps << ", giant steps: " << split.giant_steps
+         << ", 암호문 곱셈: " << split.nonscalar_multiplications << ", 레벨: " << split.depth << endl;
 
-    for (int i = 2; i <= degree; i++)
+    // 입력은 [0, 1]이므로 결과의 절댓값은 계수 절댓값의 합 이하. 소수 체인과 차수는 회로에 맞춰 정한다
+    double coeff_sum = 0.0;
 
+    for (double c : user_inputs)
     {
-        if (i % 2 == 0) // 짝수 차수 (제곱 연산)
+        coeff_sum += fabs(c);
+    }
 
-        {
-            evaluator.square(x_encrypted[i / 2], x_encrypted[i]);
-        }
+    CircuitSpec circuit;
 
-        else // 홀수 차수 (곱셈 연산)
+    circuit.depth = split.depth;
 
-        {
-            evaluator.mod_switch_to_inplace(x_encrypted[1], x_encrypted[i - 1].parms_id());
+    circuit.value_bound = max(coeff_sum, 1.0);
 
-            evaluator.multiply(x_encrypted[1], x_encrypted[i - 1], x_encrypted[i]);
-        }
+    circuit.precision_bits = 20;
 
-        evaluator.relinearize_inplace(x_encrypted[i], relin_keys);
+    circuit.ciphertext_multiplications = split.nonscalar_multiplications;
 
-        evaluator.rescale_to_next_inplace(x_encrypted[i]);
+    circuit.plain_multiplications = static_cast<size_t>(degree);
 
-        cout << "[Scale] x" << i << "_encrypted : " << log2(x_encrypted[i].scale()) << " bits" << endl;
+    ParameterPlan plan = plan_parameters(circuit);
 
-        cout << "[parms_id] x" << i
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits (";
+    for (size_t i = 0; i < plan.coeff_modulus_bits.size(); i++)
+    {
+        cout << (i ? " + " : "") << plan.coeff_modulus_bits[i];
+    }
 
-             << "_encrypted : " << context.get_context_data(x_encrypted[i].parms_id())->chain_index() << endl;
+    cout << ")" << endl;
 
-        cout << "-----------------------------< x" << i << " ok >-----------------------------" << endl;
-    }
-    Plaintext x_plain_result;
-    vector<double> reslt;
-    decryptor.decrypt(x_encrypted[3], x_plain_result);
-    encoder.decode(x_plain_result, reslt);
-    print_vector(reslt, 3, 7);
+    EncryptionParameters parms = plan.parameters();
 
-    // 사용자 입력 계수 저장
+    double scale = plan.scale();
 
-    vector<Plaintext> plain_coeffs(degree + 1);
+    SEALContext context(parms);
 
-    vector<double> user_inputs(degree + 1);
+    print_parameters(context);
 
-    for (int i = 0; i <= degree; i++)
+    KeyGenerator keygen(context);
 
-    {
-        cout << "Enter value for plain_coeff" << i << ": ";
+    auto secret_key = keygen.secret_key();
 
-        cin >> user_inputs[i];
+    PublicKey public_key;
 
-        encoder.encode(user_inputs[i], scale, plain_coeffs[i]);
-    }
+    keygen.create_public_key(public_key);
 
-    cout << "숫자 계수 Encoding completed." << endl;
-    encoder.decode(plain_coeffs[0], reslt);
-    print_vector(reslt, 3, 7);
+    RelinKeys relin_keys;
 
-    // 레벨 맞추기
+    keygen.create_relin_keys(relin_keys);
 
-    parms_id_type last_parms_id = x_encrypted[degree].parms_id();
+    Encryptor encryptor(context, public_key);
 
-    for (int i = 1; i <= degree; i++)
+    Evaluator evaluator(context);
 
-    {
-        evaluator.mod_switch_to_inplace(x_encrypted[i], last_parms_id);
-    }
+    Decryptor decryptor(context, secret_key);
 
-    for (int i = 0; i <= degree; i++)
+    CKKSEncoder encoder(context);
 
-    {
-        evaluator.mod_switch_to_inplace(plain_coeffs[i], last_parms_id);
+    OperationCosts costs = measure_operation_costs(context);
 
-        plain_coeffs[i].scale() = pow(2.0, 40);
-    }
+    cout << "예상 평가 시간: " << predict_latency_ms(circuit, plan, costs) << " ms" << endl;
+
+    size_t slot_count = encoder.slot_count();
 
-    cout << "-----------------------------< 레벨맞추기 ok >-----------------------------" << endl;
+    cout << "Number of slots: " << slot_count << endl;
 
-    // 계수 곱하기///
+    vector<double> input(slot_count);
 
-    for (int i = 1; i <= degree; i++)
+    double step_size = 1.0 / (static_cast<double>(slot_count) - 1);
 
+    for (size_t i = 0; i < slot_count; i++)
     {
-        evaluator.multiply_plain_inplace(x_encrypted[i], plain_coeffs[i]);
-        // 새로 추가한 부분. rescale 이 빠져있었음. 큰 숫자가 나온 이유가 이것 때문인듯
-        evaluator.rescale_to_next_inplace(x_encrypted[i]);
-        x_encrypted[i].scale() = pow(2.0, 40);
+        input[i] = i * step_size;
     }
 
-    cout << "Coefficients multiplied successfully." << endl;
+    cout << "Input vector:" << endl;
 
-    // // 덧셈 전에 parms_id() 맞추기 --> 이미 다 맞춰져 있어서 할 필요없음
+    print_vector(input, 3, 7);
 
-    // for (int i = 1; i <= degree; i++)
+    Ciphertext x_encrypted;
 
-    // {
+    Plaintext x_plain;
 
-    //     evaluator.mod_switch_to_inplace(x_encrypted[i], last_parms_id);
+    encoder.encode(input, scale, x_plain);
 
-    // }
+    encryptor.encrypt(x_plain, x_encrypted);
 
-    // 새로 추가한 부분. 상수항은 아직 레벨 안 맞춰져있어서 추가 했음
-    evaluator.mod_switch_to_inplace(plain_coeffs[0], x_encrypted[1].parms_id());
+    cout << "x ok" << endl;
 
-    // 결과 합산
+    PolynomialEvaluator polynomial_evaluator(context, evaluator, encoder, relin_keys);
 
-    Ciphertext encrypted_result = x_encrypted[1];
+    Ciphertext encrypted_result;
 
-    for (int i = 2; i <= degree; i++)
+    auto time_start = chrono::high_resolution_clock::now();
 
-    {
-        evaluator.add_inplace(encrypted_result, x_encrypted[i]);
-    }
+    polynomial_evaluator.evaluate_paterson_stockmeyer(x_encrypted, user_inputs, encrypted_result);
 
-    evaluator.add_plain_inplace(encrypted_result, plain_coeffs[0]);
+    auto time_end = chrono::high_resolution_clock::now();
 
-    cout << "-----------------------------< 더하기 ok >-----------------------------" << endl;
+    cout << "-----------------------------< 다항식 평가 ok >-----------------------------" << endl;
 
-    // 복호화 및 결과 출력
+    cout << "평가 시간: " << chrono::duration<double, milli>(time_end - time_start).count() << " ms" << endl;
 
+    // 복호화 및 결과 출력
     Plaintext plain_result;
 
     decryptor.decrypt(encrypted_result, plain_result);
@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "comparison.h"
+#include "examples.h"
+#include "parameter_planner.h"
+
+using namespace std;
+using namespace seal;
+
+void compare_20()
+{
+    print_example_banner("Example: CKKS Composite Sign Comparison");
+
+    int epsilon_bits;
+    cout << "|a - b| >= 2^-? 인 입력만 정확히 비교할래? (epsilon 비트): ";
+    cin >> epsilon_bits;
+    int precision_bits;
+    cout << "결과 정밀도 비트 수: ";
+    cin >> precision_bits;
+    if (epsilon_bits < 1 || precision_bits < 1)
+    {
+        cout << "비트 수는 1 이상이어야 합니다." << endl;
+        return;
+    }
+    double epsilon = ldexp(1.0, -epsilon_bits);
+
+    // epsilon과 정밀도로 g_n, f_n 합성 횟수를 정한다 (깊이가 가장 작은 것)
+    SignConfig config;
+    try
+    {
+        config = choose_sign_config(epsilon, precision_bits);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "g_n: " << config.g_n << " x " << config.g_iterations << "번, f_n: " << config.f_n << " x "
+         << config.f_iterations << "번, sign 레벨: " << config.depth << ", max 레벨: " << max_circuit_depth(config)
+         << endl;
+
+    CircuitSpec circuit;
+    circuit.depth = max_circuit_depth(config);
+    circuit.value_bound = sign_value_bound(config);
+    circuit.precision_bits = precision_bits;
+    ParameterPlan plan;
+    try
+    {
+        plan = plan_parameters(circuit);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits" << endl;
+
+    EncryptionParameters parms = plan.parameters();
+    double scale = plan.scale();
+    SEALContext context(parms);
+    print_parameters(context);
+
+    KeyGenerator keygen(context);
+    auto secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
+
+    size_t slot_count = encoder.slot_count();
+    cout << "Number of slots: " << slot_count << endl;
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<double> dist(0.0, 1.0);
+    vector<double> a(slot_count), b(slot_count);
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        a[i] = dist(gen);
+        b[i] = dist(gen);
+    }
+    cout << "a:" << endl;
+    print_vector(a, 3, 7);
+    cout << "b:" << endl;
+    print_vector(b, 3, 7);
+
+    Plaintext plain;
+    Ciphertext a_encrypted, b_encrypted;
+    encoder.encode(a, scale, plain);
+    encryptor.encrypt(plain, a_encrypted);
+    encoder.encode(b, scale, plain);
+    encryptor.encrypt(plain, b_encrypted);
+
+    Comparator comparator(context, evaluator, encoder, relin_keys, config);
+    Ciphertext compare_encrypted, max_encrypted;
+    auto time_start = chrono::high_resolution_clock::now();
+    comparator.compare(a_encrypted, b_encrypted, compare_encrypted);
+    auto time_mid = chrono::high_resolution_clock::now();
+    comparator.max(a_encrypted, b_encrypted, max_encrypted);
+    auto time_end = chrono::high_resolution_clock::now();
+    cout << "-----------------------------< 비교 ok >-----------------------------" << endl;
+    cout << "compare 시간: " << chrono::duration<double, milli>(time_mid - time_start).count() << " ms" << endl;
+    cout << "max 시간: " << chrono::duration<double, milli>(time_end - time_mid).count() << " ms" << endl;
+
+    vector<double> compare_result, max_result;
+    decryptor.decrypt(compare_encrypted, plain);
+    encoder.decode(plain, compare_result);
+    decryptor.decrypt(max_encrypted, plain);
+    encoder.decode(plain, max_result);
+    cout << "compare(a, b):" << endl;
+    print_vector(compare_result, 3, 7);
+    cout << "max(a, b):" << endl;
+    print_vector(max_result, 3, 7);
+
+    // |a - b| < epsilon인 슬롯은 근사 범위 밖이므로 오차에서 뺀다
+    double compare_error = 0.0;
+    double max_error = 0.0;
+    size_t counted = 0;
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (fabs(a[i] - b[i]) < epsilon)
+        {
+            continue;
+        }
+        counted++;
+        compare_error = max(compare_error, fabs(compare_result[i] - (a[i] > b[i] ? 1.0 : 0.0)));
+        max_error = max(max_error, fabs(max_result[i] - max(a[i], b[i])));
+    }
+    cout << "|a - b| >= epsilon 인 슬롯 " << counted << "개의 최대 오차" << endl;
+    cout << "compare: " << compare_error << " (2^" << log2(compare_error) << ")" << endl;
+    cout << "max: " << max_error << " (2^" << log2(max_error) << ")" << endl;
+}
@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "cnn.h"
+#include "examples.h"
+#include "linear_algebra.h"
+#include "parameter_planner.h"
+
+using namespace std;
+using namespace seal;
+
+void max_pool_21()
+{
+    print_example_banner("Example: CKKS Max Pooling");
+
+    FeatureMapShape shape{ 2, 0, 0 };
+    cout << "특징 맵 크기 (height width): ";
+    cin >> shape.height >> shape.width;
+    size_t window;
+    cout << "pooling 창 크기 (2 또는 3): ";
+    cin >> window;
+    int precision_bits;
+    cout << "max 정밀도 비트 수: ";
+    cin >> precision_bits;
+    if (window < 2 || window > shape.height || window > shape.width || precision_bits < 1)
+    {
+        cout << "창 크기는 2 이상, 특징 맵 크기 이하여야 합니다." << endl;
+        return;
+    }
+
+    // max는 0 근처에서 sign이 부정확해도 되므로 choose_max_config로 얕은 합성을 고른다.
+    // 오차가 라운드마다 더해지므로 max 하나는 log2(라운드 수) 비트 더 정확해야 한다
+    size_t rounds = max_pool_rounds(window);
+    int round_precision_bits = precision_bits + static_cast<int>(ceil(log2(static_cast<double>(rounds))));
+    SignConfig config;
+    size_t available;
+    try
+    {
+        config = choose_max_config(round_precision_bits);
+        available = max_supported_depth(round_precision_bits, sign_value_bound(config));
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    size_t depth = max_pool_depth(config, window);
+    cout << "g_n: " << config.g_n << " x " << config.g_iterations << "번, f_n: " << config.f_n << " x "
+         << config.f_iterations << "번, max 레벨: " << max_circuit_depth(config) << ", 라운드: " << rounds
+         << ", 전체 레벨: " << depth << endl;
+
+    // 128비트 보안 파라미터(N = 32768)에 들어가지 않는 창 크기와 정밀도는 계획하기 전에 거른다
+    if (depth > available)
+    {
+        cout << window << " x " << window << " 창을 " << precision_bits << "비트로 계산하려면 " << depth
+             << "레벨이 필요하지만 부트스트래핑 없이는 " << available << "레벨까지입니다. 정밀도를 낮추세요." << endl;
+        return;
+    }
+    cout << "pooling 뒤 conv, dense 층에 남는 레벨: " << available - depth << endl;
+
+    CircuitSpec circuit;
+    circuit.depth = depth;
+    circuit.value_bound = sign_value_bound(config);
+    circuit.precision_bits = round_precision_bits;
+    circuit.min_slots = shape.size();
+    ParameterPlan plan;
+    try
+    {
+        plan = plan_parameters(circuit);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits" << endl;
+
+    EncryptionParameters parms = plan.parameters();
+    double scale = plan.scale();
+    SEALContext context(parms);
+    print_parameters(context);
+
+    KeyGenerator keygen(context);
+    auto secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
+
+    // pooling 회전 step만 키로 만든다
+    RotationKeyPlanner key_planner;
+    for (int step : max_pool_steps(shape, window))
+    {
+        key_planner.add_step(step);
+    }
+    GaloisKeys galois_keys;
+    key_planner.create_galois_keys(keygen, galois_keys);
+
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<double> dist(0.0, 1.0);
+    vector<vector<vector<double>>> maps(
+        shape.channels, vector<vector<double>>(shape.height, vector<double>(shape.width)));
+    for (auto &channel : maps)
+    {
+        for (auto &row : channel)
+        {
+            for (double &v : row)
+            {
+                v = dist(gen);
+            }
+        }
+    }
+    vector<double> input = pack_feature_map(maps);
+    cout << "Input feature map:" << endl;
+    print_vector(input, 3, 7);
+
+    Plaintext plain;
+    Ciphertext encrypted;
+    encoder.encode(input, scale, plain);
+    encryptor.encrypt(plain, encrypted);
+
+    Comparator comparator(context, evaluator, encoder, relin_keys, config);
+    Ciphertext pooled;
+    auto time_start = chrono::high_resolution_clock::now();
+    max_pool(comparator, evaluator, galois_keys, shape, window, encrypted, pooled);
+    auto time_end = chrono::high_resolution_clock::now();
+    cout << "-----------------------------< max pooling ok >-----------------------------" << endl;
+    cout << "pooling 시간: " << chrono::duration<double, milli>(time_end - time_start).count() << " ms" << endl;
+    cout << "사용한 레벨: "
+         << context.get_context_data(encrypted.parms_id())->chain_index() -
+                context.get_context_data(pooled.parms_id())->chain_index()
+         << endl;
+
+    vector<double> result;
+    decryptor.decrypt(pooled, plain);
+    encoder.decode(plain, result);
+
+    // stride = window인 창들만 읽어서 평문 max pooling과 비교한다
+    double max_error = 0.0;
+    for (size_t c = 0; c < shape.channels; c++)
+    {
+        for (size_t r = 0; r + window <= shape.height; r += window)
+        {
+            for (size_t col = 0; col + window <= shape.width; col += window)
+            {
+                double expected = 0.0;
+                for (size_t i = 0; i < window; i++)
+                {
+                    for (size_t j = 0; j < window; j++)
+                    {
+                        expected = max(expected, maps[c][r + i][col + j]);
+                    }
+                }
+                max_error = max(max_error, fabs(result[shape.slot(c, r, col)] - expected));
+                if (c == 0 && r == 0)
+                {
+                    cout << "창 (0, " << col << "): " << result[shape.slot(c, r, col)] << " (기대값 " << expected
+                         << ")" << endl;
+                }
+            }
+        }
+    }
+    cout << "최대 오차: " << max_error << " (2^" << log2(max_error) << ")" << endl;
+}
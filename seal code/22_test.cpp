@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "cnn.h"
+#include "examples.h"
+#include "parameter_planner.h"
+
+using namespace std;
+using namespace seal;
+
+void relu_22()
+{
+    print_example_banner("Example: CKKS ReLU Approximation Presets");
+
+    double bound;
+    cout << "입력 범위 [-B, B]의 B: ";
+    cin >> bound;
+    size_t degree;
+    cout << "최소제곱 근사 차수: ";
+    cin >> degree;
+    int precision_bits;
+    cout << "합성 근사 정밀도 비트 수: ";
+    cin >> precision_bits;
+    if (!(bound > 0.0) || degree < 2 || precision_bits < 1)
+    {
+        cout << "B는 양수, 차수는 2 이상, 정밀도는 1 이상이어야 합니다." << endl;
+        return;
+    }
+
+    vector<pair<string, ReluApproximation>> presets;
+    try
+    {
+        presets.emplace_back("square", make_relu_approximation(ReluPreset::square, bound));
+        presets.emplace_back(
+            "least squares (" + to_string(degree) + "차)",
+            make_relu_approximation(ReluPreset::least_squares, bound, degree));
+        presets.emplace_back(
+            "composite (2^-" + to_string(precision_bits) + ")",
+            make_relu_approximation(ReluPreset::composite, bound, 0, precision_bits));
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+
+    // 가장 깊은 근사에 맞춰 파라미터를 한 번만 정하고 모든 근사를 같은 입력에 적용한다
+    CircuitSpec circuit{ 0, 1.0, 20 };
+    for (const auto &preset : presets)
+    {
+        circuit.depth = max(circuit.depth, preset.second.depth);
+        circuit.value_bound = max(circuit.value_bound, relu_value_bound(preset.second));
+        cout << preset.first << ": 레벨 " << preset.second.depth << ", 평문 오차 " << relu_plain_error(preset.second)
+             << endl;
+    }
+    ParameterPlan plan;
+    try
+    {
+        plan = plan_parameters(circuit);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits" << endl;
+
+    EncryptionParameters parms = plan.parameters();
+    double scale = plan.scale();
+    SEALContext context(parms);
+    print_parameters(context);
+
+    KeyGenerator keygen(context);
+    auto secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
+
+    // 슬롯 전체를 활성값으로 채운다 ([-B, B] 균등 간격)
+    size_t slot_count = encoder.slot_count();
+    cout << "Number of slots: " << slot_count << endl;
+    vector<double> input(slot_count);
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        input[i] = -bound + 2.0 * bound * static_cast<double>(i) / static_cast<double>(slot_count - 1);
+    }
+    cout << "Input vector:" << endl;
+    print_vector(input, 3, 7);
+
+    Plaintext plain;
+    Ciphertext encrypted;
+    encoder.encode(input, scale, plain);
+    encryptor.encrypt(plain, encrypted);
+    size_t input_index = context.get_context_data(encrypted.parms_id())->chain_index();
+
+    for (const auto &preset : presets)
+    {
+        ReluLayer layer(context, evaluator, encoder, relin_keys, preset.second);
+        Ciphertext activated;
+        auto time_start = chrono::high_resolution_clock::now();
+        layer.apply(encrypted, activated);
+        auto time_end = chrono::high_resolution_clock::now();
+
+        vector<double> result;
+        decryptor.decrypt(activated, plain);
+        encoder.decode(plain, result);
+        double max_error = 0.0;
+        for (size_t i = 0; i < slot_count; i++)
+        {
+            max_error = max(max_error, fabs(result[i] - max(input[i], 0.0)));
+        }
+
+        cout << "-----------------------------< " << preset.first << " >-----------------------------" << endl;
+        print_vector(result, 3, 7);
+        cout << "사용한 레벨: " << input_index - context.get_context_data(activated.parms_id())->chain_index()
+             << ", 최대 오차: " << max_error << ", 시간: "
+             << chrono::duration<double, milli>(time_end - time_start).count() << " ms" << endl;
+    }
+}
@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "cnn.h"
+#include "examples.h"
+#include "linear_algebra.h"
+#include "parameter_planner.h"
+
+using namespace std;
+using namespace seal;
+
+void conv2d_23()
+{
+    print_example_banner("Example: CKKS Packed 2D Convolution");
+
+    Conv2dShape shape{ FeatureMapShape{ 0, 0, 0 }, 0, 0, 1, 0 };
+    cout << "입력 크기 (channels height width): ";
+    cin >> shape.input.channels >> shape.input.height >> shape.input.width;
+    cout << "출력 채널 수: ";
+    cin >> shape.output_channels;
+    cout << "커널 크기, stride, padding: ";
+    cin >> shape.kernel_size >> shape.stride >> shape.padding;
+
+    // 커널 가중치 [-0.5, 0.5], 입력 [0, 1]이면 출력의 절댓값은 channels * kernel_size^2 / 2 이하
+    CircuitSpec circuit;
+    circuit.depth = 1;
+    circuit.value_bound = max(1.0, 0.5 * static_cast<double>(shape.input.channels * shape.kernel_size * shape.kernel_size));
+    circuit.precision_bits = 20;
+    circuit.min_slots = shape.input_blocks() * shape.input.height * shape.input.width;
+    circuit.plain_multiplications = shape.input.channels * shape.kernel_size * shape.kernel_size;
+    circuit.rotations = conv2d_rotation_count(shape);
+    ParameterPlan plan;
+    try
+    {
+        plan = plan_parameters(circuit);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits" << endl;
+
+    EncryptionParameters parms = plan.parameters();
+    double scale = plan.scale();
+    SEALContext context(parms);
+    print_parameters(context);
+
+    KeyGenerator keygen(context);
+    auto secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
+
+    OperationCosts costs = measure_operation_costs(context);
+
+    cout << "예상 평가 시간: " << predict_latency_ms(circuit, plan, costs) << " ms" << endl;
+
+    size_t slot_count = encoder.slot_count();
+
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<double> pixel(0.0, 1.0);
+    uniform_real_distribution<double> weight(-0.5, 0.5);
+    vector<vector<vector<double>>> maps(
+        shape.input.channels, vector<vector<double>>(shape.input.height, vector<double>(shape.input.width)));
+    for (auto &channel : maps)
+    {
+        for (auto &row : channel)
+        {
+            for (double &v : row)
+            {
+                v = pixel(gen);
+            }
+        }
+    }
+    ConvKernel kernel(
+        shape.output_channels,
+        vector<vector<vector<double>>>(
+            shape.input.channels,
+            vector<vector<double>>(shape.kernel_size, vector<double>(shape.kernel_size))));
+    for (auto &per_output : kernel)
+    {
+        for (auto &taps : per_output)
+        {
+            for (auto &row : taps)
+            {
+                for (double &w : row)
+                {
+                    w = weight(gen);
+                }
+            }
+        }
+    }
+
+    vector<double> input;
+    try
+    {
+        input = replicate_channels(shape, pack_feature_map(maps), slot_count);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "Input feature map:" << endl;
+    print_vector(input, 3, 7);
+
+    // 탭 회전과 채널 오프셋 회전 step만 키로 만든다
+    RotationKeyPlanner key_planner;
+    for (int step : conv2d_steps(shape))
+    {
+        key_planner.add_step(step);
+    }
+    GaloisKeys galois_keys;
+    key_planner.create_galois_keys(keygen, galois_keys);
+
+    // 가중치는 서비스 시작 시 한 번만 인코딩한다
+    WeightCache weights = make_conv2d_weights(encoder, shape, kernel);
+    weights.prepare_rescale_levels(context);
+
+    Plaintext plain;
+    Ciphertext encrypted;
+    encoder.encode(input, scale, plain);
+    encryptor.encrypt(plain, encrypted);
+
+    Ciphertext convolved;
+    auto time_start = chrono::high_resolution_clock::now();
+    conv2d(context, evaluator, galois_keys, shape, weights, encrypted, convolved);
+    auto time_end = chrono::high_resolution_clock::now();
+    size_t taps = shape.kernel_size * shape.kernel_size;
+    cout << "-----------------------------< conv2d ok >-----------------------------" << endl;
+    cout << "conv2d 시간: " << chrono::duration<double, milli>(time_end - time_start).count() << " ms" << endl;
+    cout << "회전: " << conv2d_rotation_count(shape) << "번 (탭마다 채널마다 회전하면 "
+         << shape.input.channels * taps - 1 << "번), multiply_plain: " << weights.size() << "번" << endl;
+
+    vector<double> result;
+    decryptor.decrypt(convolved, plain);
+    encoder.decode(plain, result);
+
+    // 평문 합성곱과 비교 (padding 밖은 0)
+    double max_error = 0.0;
+    for (size_t o = 0; o < shape.output_channels; o++)
+    {
+        for (size_t i = 0; i < shape.output_height(); i++)
+        {
+            for (size_t j = 0; j < shape.output_width(); j++)
+            {
+                double expected = 0.0;
+                for (size_t c = 0; c < shape.input.channels; c++)
+                {
+                    for (size_t row = 0; row < shape.kernel_size; row++)
+                    {
+                        for (size_t col = 0; col < shape.kernel_size; col++)
+                        {
+                            size_t r = i * shape.stride + row;
+                            size_t s = j * shape.stride + col;
+                            if (r < shape.padding || s < shape.padding || r - shape.padding >= shape.input.height ||
+                                s - shape.padding >= shape.input.width)
+                            {
+                                continue;
+                            }
+                            expected += kernel[o][c][row][col] * maps[c][r - shape.padding][s - shape.padding];
+                        }
+                    }
+                }
+                double actual = result[shape.output_slot(o, i, j)];
+                max_error = max(max_error, fabs(actual - expected));
+                if (o == 0 && i == 0 && j < 4)
+                {
+                    cout << "출력 (0, 0, " << j << "): " << actual << " (기대값 " << expected << ")" << endl;
+                }
+            }
+        }
+    }
+    cout << "최대 오차: " << max_error << " (2^" << log2(max_error) << ")" << endl;
+}
@@ -0,0 +1,171 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "cnn.h"
+#include "examples.h"
+#include "parameter_planner.h"
+
+using namespace std;
+using namespace seal;
+
+void batched_inference_24()
+{
+    print_example_banner("Example: CKKS Batched CNN Inference (one image per slot)");
+
+    SmallCnn model;
+    model.conv = Conv2dShape{ FeatureMapShape{ 1, 0, 0 }, 0, 0, 1, 0 };
+    cout << "이미지 크기 (height width): ";
+    cin >> model.conv.input.height >> model.conv.input.width;
+    cout << "conv 출력 채널 수, 커널 크기, stride: ";
+    cin >> model.conv.output_channels >> model.conv.kernel_size >> model.conv.stride;
+    cout << "평균 pooling 창 크기: ";
+    cin >> model.pool_window;
+    size_t classes;
+    cout << "출력 클래스 수: ";
+    cin >> classes;
+    const Conv2dShape &conv = model.conv;
+    if (conv.input.height == 0 || conv.input.width == 0 || conv.kernel_size == 0 || conv.stride == 0 ||
+        conv.output_channels == 0 || classes == 0 || conv.kernel_size > conv.input.height ||
+        conv.kernel_size > conv.input.width || model.pool_window == 0 ||
+        model.pool_window > conv.output_height() || model.pool_window > conv.output_width())
+    {
+        cout << "층 크기는 1 이상이고 커널은 이미지보다, pooling 창은 conv 출력보다 작아야 합니다." << endl;
+        return;
+    }
+
+    // 임의의 모델. 값이 너무 커지지 않도록 가중치를 팬인으로 나눈다
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    double conv_range = 1.0 / static_cast<double>(conv.kernel_size);
+    model.conv_kernel.assign(
+        conv.output_channels,
+        vector<vector<vector<double>>>(
+            conv.input.channels, vector<vector<double>>(conv.kernel_size, vector<double>(conv.kernel_size))));
+    for (auto &per_output : model.conv_kernel)
+    {
+        for (auto &taps : per_output)
+        {
+            for (auto &row : taps)
+            {
+                for (double &w : row)
+                {
+                    w = conv_range * dist(gen);
+                }
+            }
+        }
+    }
+    model.conv_bias.resize(conv.output_channels);
+    for (double &b : model.conv_bias)
+    {
+        b = 0.1 * dist(gen);
+    }
+    size_t features = model.pooled_shape().size();
+    model.dense.assign(classes, vector<double>(features));
+    for (auto &row : model.dense)
+    {
+        for (double &w : row)
+        {
+            w = dist(gen) / sqrt(static_cast<double>(features));
+        }
+    }
+    model.dense_bias.resize(classes);
+    for (double &b : model.dense_bias)
+    {
+        b = 0.1 * dist(gen);
+    }
+
+    // 파라미터는 레벨 3개와 평문 추론의 중간값 상한으로 정한다
+    CircuitSpec circuit;
+    circuit.depth = BatchedCnn::depth();
+    circuit.value_bound = 1.0;
+    circuit.precision_bits = 20;
+    ParameterPlan plan;
+    vector<vector<double>> images;
+    vector<vector<double>> expected;
+    try
+    {
+        plan = plan_parameters(circuit);
+        size_t batch_size = plan.poly_modulus_degree / 2;
+        uniform_real_distribution<double> pixel(0.0, 1.0);
+        images.assign(batch_size, vector<double>(conv.input.size()));
+        for (auto &image : images)
+        {
+            for (double &v : image)
+            {
+                v = pixel(gen);
+            }
+            double max_abs;
+            expected.push_back(evaluate_small_cnn(model, image, &max_abs));
+            circuit.value_bound = max(circuit.value_bound, max_abs);
+        }
+        plan = plan_parameters(circuit);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << "poly_modulus_degree: " << plan.poly_modulus_degree << ", coeff_modulus: " << plan.total_bits << " / "
+         << plan.max_bits << " bits" << endl;
+
+    EncryptionParameters parms = plan.parameters();
+    double scale = plan.scale();
+    SEALContext context(parms);
+    print_parameters(context);
+
+    KeyGenerator keygen(context);
+    auto secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
+
+    // value_bound로 poly_modulus_degree가 커졌으면 늘어난 슬롯만큼 이미지를 더 만들지 않고 앞쪽만 쓴다
+    size_t batch_size = min(images.size(), encoder.slot_count());
+    images.resize(batch_size);
+    cout << "한 번에 추론하는 이미지: " << batch_size << "장 (픽셀마다 암호문 하나, " << conv.input.size() << "개)"
+         << endl;
+
+    BatchedCnn network(context, evaluator, encoder, relin_keys, model);
+    network.prepare();
+    ParallelExecutor executor;
+
+    vector<Ciphertext> pixels;
+    vector<Ciphertext> logits;
+    auto time_start = chrono::high_resolution_clock::now();
+    encrypt_image_batch(encoder, encryptor, images, scale, pixels, executor);
+    auto time_mid = chrono::high_resolution_clock::now();
+    network.infer(pixels, logits, executor);
+    auto time_end = chrono::high_resolution_clock::now();
+
+    double infer_ms = chrono::duration<double, milli>(time_end - time_mid).count();
+    cout << "-----------------------------< 배치 추론 ok >-----------------------------" << endl;
+    cout << "스레드: " << executor.thread_count() << endl;
+    cout << "암호화 시간: " << chrono::duration<double, milli>(time_mid - time_start).count() << " ms" << endl;
+    cout << "추론 시간: " << infer_ms << " ms (이미지당 " << infer_ms / static_cast<double>(batch_size) << " ms, "
+         << static_cast<double>(batch_size) * 1000.0 / infer_ms << " images/s)" << endl;
+
+    auto result = decrypt_image_batch(encoder, decryptor, logits, batch_size);
+    double max_error = 0.0;
+    size_t agree = 0;
+    for (size_t b = 0; b < batch_size; b++)
+    {
+        for (size_t k = 0; k < classes; k++)
+        {
+            max_error = max(max_error, fabs(result[b][k] - expected[b][k]));
+        }
+        auto argmax = [](const vector<double> &v) { return max_element(v.begin(), v.end()) - v.begin(); };
+        agree += argmax(result[b]) == argmax(expected[b]) ? 1 : 0;
+    }
+    cout << "이미지 0 출력:" << endl;
+    print_vector(result[0], 3, 7);
+    cout << "평문 출력:" << endl;
+    print_vector(expected[0], 3, 7);
+    cout << "최대 오차: " << max_error << " (2^" << log2(max_error) << "), 평문과 같은 클래스: " << agree << " / "
+         << batch_size << endl;
+}
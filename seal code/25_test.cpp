@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "examples.h"
+#include "low_latency.h"
+#include "parameter_planner.h"
+
+using namespace std;
+using namespace seal;
+
+void low_latency_25()
+{
+    print_example_banner("Example: CKKS Low-Latency Inference with Representation Switching");
+
+    Conv2dShape conv{ FeatureMapShape{ 1, 0, 0 }, 0, 0, 1, 0 };
+    cout << "이미지 크기 (height width): ";
+    cin >> conv.input.height >> conv.input.width;
+    cout << "conv 출력 채널 수, 커널 크기, stride, padding: ";
+    cin >> conv.output_channels >> conv.kernel_size >> conv.stride >> conv.padding;
+    size_t hidden, classes;
+    cout << "은닉층 크기, 출력 클래스 수: ";
+    cin >> hidden >> classes;
+    if (conv.kernel_size == 0 || conv.stride == 0 || conv.output_channels == 0 || hidden == 0 || classes == 0 ||
+        conv.kernel_size > conv.input.height + 2 * conv.padding || conv.kernel_size > conv.input.width + 2 * conv.padding)
+    {
+        cout << "층 크기는 1 이상이고 커널은 padding을 포함한 이미지보다 작아야 합니다." << endl;
+        return;
+    }
+
+    // conv -> x^2 -> dense -> x^2 -> dense. 값이 너무 커지지 않도록 가중치를 팬인으로 나눈다
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    auto random_matrix = [&](size_t rows, size_t cols) {
+        vector<vector<double>> matrix(rows, vector<double>(cols));
+        for (auto &row : matrix)
+        {
+            for (double &w : row)
+            {
+                w = dist(gen) / sqrt(static_cast<double>(cols));
+            }
+        }
+        return matrix;
+    };
+    auto random_vector = [&](size_t size) {
+        vector<double> values(size);
+        for (double &v : values)
+        {
+            v = 0.1 * dist(gen);
+        }
+        return values;
+    };
+    ConvKernel kernel(
+        conv.output_channels,
+        vector<vector<vector<double>>>(
+            conv.input.channels, vector<vector<double>>(conv.kernel_size, vector<double>(conv.kernel_size))));
+    for (auto &per_output : kernel)
+    {
+        for (auto &taps : per_output)
+        {
+            taps = random_matrix(conv.kernel_size, conv.kernel_size);
+        }
+    }
+    size_t conv_outputs = conv.output_channels * conv.output_height() * conv.output_width();
+    vector<NetworkLayer> layers;
+    layers.push_back(make_conv_layer(conv, kernel, random_vector(conv.output_channels)));
+    layers.push_back(make_square_layer());
+    layers.push_back(make_dense_layer(random_matrix(hidden, conv_outputs), random_vector(hidden)));
+    layers.push_back(make_square_layer());
+    layers.push_back(make_dense_layer(random_matrix(classes, hidden), random_vector(classes)));
+
+    vector<double> image(conv.input.size());
+    uniform_real_distribution<double> pixel(0.0, 1.0);
+    for (double &v : image)
+    {
+        v = pixel(gen);
+    }
+    double max_abs;
+    vector<double> expected = evaluate_network(layers, image, &max_abs);
+
+    auto packing_name = [](Packing packing) {
+        switch (packing)
+        {
+        case Packing::convolution:
+            return "convolution";
+        case Packing::dense:
+            return "dense";
+        case Packing::stacked:
+            return "stacked";
+        default:
+            return "interleaved";
+        }
+    };
+    auto print_plan = [&](const string &title, const NetworkPlan &plan) {
+        cout << title << ": 임계 경로 회전 " << plan.critical_rotations << "번, 전체 회전 " << plan.total_rotations
+             << "번, 레벨 " << plan.depth << endl;
+        for (size_t i = 0; i < plan.layers.size(); i++)
+        {
+            const LayerPlan &layer = plan.layers[i];
+            cout << "  층 " << i << ": " << packing_name(layer.packing) << ", 변환 회전 " << layer.conversion_rotations
+                 << " (레벨 " << layer.conversion_levels << "), 층 회전 " << layer.rotations << ", 출력 암호문 "
+                 << layer.output_ciphertexts << endl;
+        }
+    };
+
+    // 표현은 슬롯 수에 따라 달라지므로 작은 차수부터 차례로 계획해 보고, 그 계획의 깊이가 같은 차수의
+    // 128비트 보안 소수 체인에 들어가는 첫 차수를 쓴다. value_bound는 예제 24처럼 평문 추론의 중간값 상한
+    // 그대로 (plan_parameters가 첫 소수에 2비트 여유를 둔다)
+    CircuitSpec circuit;
+    circuit.value_bound = max(1.0, max_abs);
+    circuit.precision_bits = 20;
+    NetworkPlan plan;
+    ParameterPlan parameters{};
+    bool planned = false;
+    string failure = "network does not fit into the slots";
+    for (size_t poly_modulus_degree = 1024; !planned && poly_modulus_degree <= 32768; poly_modulus_degree *= 2)
+    {
+        try
+        {
+            plan = plan_network(layers, poly_modulus_degree / 2);
+            circuit.depth = plan.depth;
+            circuit.min_slots = poly_modulus_degree / 2;
+            parameters = plan_parameters(circuit);
+            planned = parameters.poly_modulus_degree == poly_modulus_degree;
+        }
+        catch (const invalid_argument &e)
+        {
+            failure = e.what();
+        }
+    }
+    if (!planned)
+    {
+        cout << failure << endl;
+        return;
+    }
+    size_t slot_count = parameters.poly_modulus_degree / 2;
+    print_plan("선택한 표현", plan);
+
+    // 모든 층을 한 가지 표현으로 계산할 때와 비교한다
+    for (Packing packing : { Packing::dense, Packing::stacked })
+    {
+        try
+        {
+            print_plan(
+                string("모든 층 ") + packing_name(packing),
+                plan_network(layers, vector<Packing>(layers.size(), packing), slot_count));
+        }
+        catch (const invalid_argument &e)
+        {
+            cout << "모든 층 " << packing_name(packing) << ": " << e.what() << endl;
+        }
+    }
+    cout << "poly_modulus_degree: " << parameters.poly_modulus_degree << ", coeff_modulus: " << parameters.total_bits
+         << " / " << parameters.max_bits << " bits" << endl;
+
+    EncryptionParameters parms = parameters.parameters();
+    double scale = parameters.scale();
+    SEALContext context(parms);
+    print_parameters(context);
+
+    KeyGenerator keygen(context);
+    auto secret_key = keygen.secret_key();
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+    CKKSEncoder encoder(context);
+
+    LowLatencyNetwork network(context, evaluator, encoder, relin_keys, layers, plan);
+    RotationKeyPlanner key_planner;
+    for (int step : network.galois_steps())
+    {
+        key_planner.add_step(step);
+    }
+    GaloisKeys galois_keys;
+    key_planner.create_galois_keys(keygen, galois_keys);
+    cout << "Galois 키: " << key_planner.steps().size() << "개" << endl;
+
+    Plaintext plain;
+    Ciphertext encrypted;
+    encoder.encode(network.encode_input(image), scale, plain);
+    encryptor.encrypt(plain, encrypted);
+
+    // 첫 추론은 가중치 인코딩을 포함하므로 두 번째 추론 시간을 잰다
+    ParallelExecutor executor;
+    vector<Ciphertext> logits;
+    network.infer(galois_keys, encrypted, logits, executor);
+    auto time_start = chrono::high_resolution_clock::now();
+    network.infer(galois_keys, encrypted, logits, executor);
+    auto time_end = chrono::high_resolution_clock::now();
+    cout << "-----------------------------< 저지연 추론 ok >-----------------------------" << endl;
+    cout << "추론 시간: " << chrono::duration<double, milli>(time_end - time_start).count() << " ms (스레드 "
+         << executor.thread_count() << ")" << endl;
+
+    vector<double> result = network.decrypt_output(encoder, decryptor, logits);
+    double max_error = 0.0;
+    for (size_t k = 0; k < classes; k++)
+    {
+        max_error = max(max_error, fabs(result[k] - expected[k]));
+    }
+    cout << "출력:" << endl;
+    print_vector(result, 3, 7);
+    cout << "평문 출력:" << endl;
+    print_vector(expected, 3, 7);
+    cout << "최대 오차: " << max_error << " (2^" << log2(max_error) << ")" << endl;
+}
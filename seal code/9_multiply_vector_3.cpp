@@ -1,5 +1,6 @@
 #include <iomanip> //출력 포맷 조정 위한 헤더
 #include "examples.h"
+#include "linear_algebra.h"
 
 using namespace seal;
 using namespace std;
@@ -31,8 +32,6 @@ void example_multiply_vector_matrix_3()
     keygen.create_public_key(public_key);
     RelinKeys relin_keys;
     keygen.create_relin_keys(relin_keys);
-    GaloisKeys galois_keys;
-    keygen.create_galois_keys(galois_keys); // rotation 위한 Galois 키 생성
 
     Encryptor encryptor(context, public_key);
     Evaluator evaluator(context); // 평가 객체(동형 연산 수행)
@@ -43,6 +42,12 @@ void example_multiply_vector_matrix_3()
     size_t slot_count = encoder.slot_count(); // 사용 가능한 슬롯 개수 확인
     size_t vector_size = 3; // 입력벡터 및 행렬 크기
 
+    // 내적 합산에 필요한 회전 키(1, 2, 4, ...)만 생성
+    RotationKeyPlanner key_planner;
+    key_planner.add_rotate_and_sum(vector_size);
+    GaloisKeys galois_keys;
+    key_planner.create_galois_keys(keygen, galois_keys);
+
     vector<double> input_vector = { 1.0, 2.0, 3.0};
     vector<vector<double>> matrix = {
         { 1.0, 2.0, 3.0}, { 5.0, 6.0, 7.0}, { 9.0, 10.0, 11.0}
@@ -84,14 +89,9 @@ void example_multiply_vector_matrix_3()
         // 스케일 재설정
         temp.scale() = scale;
 
-        // 회전 결과 누적 합산
-        Ciphertext sum = temp;
-        for (size_t rot = 1; rot < vector_size; rot++)
-        {
-            Ciphertext rotated;
-            evaluator.rotate_vector(temp, rot, galois_keys, rotated); // 벡터 회전
-            evaluator.add_inplace(sum, rotated); // 누적 합산
-        }
+        // 회전 결과 누적 합산 (ceil(log2 N)번 회전)
+        Ciphertext sum;
+        rotate_and_sum(evaluator, galois_keys, temp, vector_size, sum);
 
         row_results.push_back(sum); // 현재 행의 회전 결과 저장
     }
@@ -0,0 +1,148 @@
+#include "aligned_evaluator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace
+{
+    // SEAL의 are_close와 같은 기준
+    bool same_scale(double a, double b)
+    {
+        double scaled_epsilon = max(fabs(a), fabs(b)) * numeric_limits<double>::epsilon();
+        return fabs(a - b) < scaled_epsilon;
+    }
+} // namespace
+
+AlignedEvaluator::AlignedEvaluator(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys)
+    : evaluator_(evaluator), relin_keys_(relin_keys), scales_(context, evaluator, encoder)
+{}
+
+const Ciphertext *AlignedEvaluator::align(
+    const Ciphertext &encrypted, parms_id_type parms_id, Ciphertext &aligned) const
+{
+    size_t from = scales_.chain_index(encrypted.parms_id());
+    size_t to = scales_.chain_index(parms_id);
+    if (from <= to)
+    {
+        return &encrypted;
+    }
+    evaluator_.mod_switch_to(encrypted, parms_id, aligned);
+    mod_switch_count_++;
+    dropped_levels_ += from - to;
+    return &aligned;
+}
+
+void AlignedEvaluator::add(const Ciphertext &a, const Ciphertext &b, Ciphertext &destination) const
+{
+    size_t a_index = scales_.chain_index(a.parms_id());
+    size_t b_index = scales_.chain_index(b.parms_id());
+    const Ciphertext &high = (a_index >= b_index) ? a : b;
+    const Ciphertext &low = (a_index >= b_index) ? b : a;
+
+    Ciphertext aligned;
+    if (same_scale(high.scale(), low.scale()))
+    {
+        evaluator_.add(*align(high, low.parms_id(), aligned), low, destination);
+        return;
+    }
+    if (a_index == b_index)
+    {
+        throw invalid_argument("operands at the same level must have the same scale");
+    }
+    scales_.multiply_const(high, 1.0, low.parms_id(), low.scale(), aligned);
+    scale_fix_count_++;
+    dropped_levels_ += max(a_index, b_index) - min(a_index, b_index);
+    evaluator_.add(aligned, low, destination);
+}
+
+void AlignedEvaluator::add_inplace(Ciphertext &a, const Ciphertext &b) const
+{
+    Ciphertext sum;
+    add(a, b, sum);
+    a = move(sum);
+}
+
+void AlignedEvaluator::sub(const Ciphertext &a, const Ciphertext &b, Ciphertext &destination) const
+{
+    Ciphertext negated;
+    evaluator_.negate(b, negated);
+    add(a, negated, destination);
+}
+
+void AlignedEvaluator::multiply(
+    const Ciphertext &a, const Ciphertext &b, Ciphertext &destination, bool relinearize) const
+{
+    size_t a_index = scales_.chain_index(a.parms_id());
+    size_t b_index = scales_.chain_index(b.parms_id());
+    Ciphertext aligned;
+    if (&a == &b)
+    {
+        evaluator_.square(a, destination);
+    }
+    else if (a_index > b_index)
+    {
+        evaluator_.multiply(*align(a, b.parms_id(), aligned), b, destination);
+    }
+    else
+    {
+        evaluator_.multiply(a, *align(b, a.parms_id(), aligned), destination);
+    }
+    if (relinearize)
+    {
+        evaluator_.relinearize_inplace(destination, relin_keys_);
+    }
+    evaluator_.rescale_to_next_inplace(destination);
+}
+
+void AlignedEvaluator::multiply_plain(const Ciphertext &encrypted, const Plaintext &plain, Ciphertext &destination) const
+{
+    size_t encrypted_index = scales_.chain_index(encrypted.parms_id());
+    size_t plain_index = scales_.chain_index(plain.parms_id());
+    if (plain_index > encrypted_index)
+    {
+        Plaintext aligned;
+        evaluator_.mod_switch_to(plain, encrypted.parms_id(), aligned);
+        mod_switch_count_++;
+        dropped_levels_ += plain_index - encrypted_index;
+        evaluator_.multiply_plain(encrypted, aligned, destination);
+    }
+    else
+    {
+        Ciphertext aligned;
+        evaluator_.multiply_plain(*align(encrypted, plain.parms_id(), aligned), plain, destination);
+    }
+}
+
+void AlignedEvaluator::add_plain_inplace(Ciphertext &encrypted, const Plaintext &plain) const
+{
+    size_t encrypted_index = scales_.chain_index(encrypted.parms_id());
+    size_t plain_index = scales_.chain_index(plain.parms_id());
+    if (plain_index < encrypted_index)
+    {
+        evaluator_.mod_switch_to_inplace(encrypted, plain.parms_id());
+        mod_switch_count_++;
+        dropped_levels_ += encrypted_index - plain_index;
+    }
+    if (plain_index <= encrypted_index)
+    {
+        evaluator_.add_plain_inplace(encrypted, plain);
+        return;
+    }
+    Plaintext aligned;
+    evaluator_.mod_switch_to(plain, encrypted.parms_id(), aligned);
+    mod_switch_count_++;
+    dropped_levels_ += plain_index - encrypted_index;
+    evaluator_.add_plain_inplace(encrypted, aligned);
+}
+
+void AlignedEvaluator::reset_counters() const
+{
+    mod_switch_count_ = 0;
+    dropped_levels_ = 0;
+    scale_fix_count_ = 0;
+}
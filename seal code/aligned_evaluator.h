@@ -0,0 +1,94 @@
+#pragma once
+
+#include "scale_manager.h"
+#include "seal/seal.h"
+#include <atomic>
+#include <cstddef>
+
+/*
+레벨이 다른 암호문끼리의 식을 계산하는 Evaluator 래퍼.
+피연산자는 바꾸지 않고, 연산 직전에 레벨이 높은 쪽의 복사본만 낮은 쪽 레벨로 내린다.
+그래서 x처럼 여러 곳에서 쓰는 높은 레벨의 암호문을 미리 mod_switch_to_inplace로 끌어내릴 필요가 없고,
+같은 암호문을 여러 번 내리는 일도 없다. 넣은 mod switch 수와 내린 레벨 수를 센다.
+*/
+class AlignedEvaluator
+{
+public:
+    AlignedEvaluator(
+        const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+        const seal::RelinKeys &relin_keys);
+
+    /*
+    a + b. 레벨이 같으면 scale도 같아야 한다. 레벨이 다르고 scale도 다르면 높은 쪽에 1을 곱해서
+    (ScaleManager::multiply_const) 낮은 쪽 레벨, 낮은 쪽 scale로 정확히 맞춘다. 이때 레벨을 더 쓰지 않는다.
+    */
+    void add(const seal::Ciphertext &a, const seal::Ciphertext &b, seal::Ciphertext &destination) const;
+
+    void add_inplace(seal::Ciphertext &a, const seal::Ciphertext &b) const;
+
+    /*
+    a - b. 레벨과 scale은 add와 같이 맞춘다.
+    */
+    void sub(const seal::Ciphertext &a, const seal::Ciphertext &b, seal::Ciphertext &destination) const;
+
+    /*
+    레벨을 맞춰 곱한 뒤 relinearize, rescale한다.
+    relinearize가 false이면 결과를 크기 3으로 둔다. 평문 곱과 덧셈만 거칠 암호문은 합을 만든 뒤
+    한 번만 relinearize하면 되므로 key switch를 아낄 수 있다.
+    */
+    void multiply(
+        const seal::Ciphertext &a, const seal::Ciphertext &b, seal::Ciphertext &destination,
+        bool relinearize = true) const;
+
+    /*
+    암호문과 평문 중 레벨이 높은 쪽을 내려서 곱한다 (rescale하지 않음).
+    */
+    void multiply_plain(
+        const seal::Ciphertext &encrypted, const seal::Plaintext &plain, seal::Ciphertext &destination) const;
+
+    /*
+    암호문과 평문 중 레벨이 높은 쪽을 내려서 더한다. scale은 같아야 한다.
+    */
+    void add_plain_inplace(seal::Ciphertext &encrypted, const seal::Plaintext &plain) const;
+
+    std::size_t mod_switch_count() const
+    {
+        return mod_switch_count_;
+    }
+
+    std::size_t dropped_levels() const
+    {
+        return dropped_levels_;
+    }
+
+    std::size_t scale_fix_count() const
+    {
+        return scale_fix_count_;
+    }
+
+    void reset_counters() const;
+
+    const ScaleManager &scales() const
+    {
+        return scales_;
+    }
+
+private:
+    /*
+    encrypted가 parms_id보다 높은 레벨이면 내린 복사본을 aligned에 만들고 그 주소를, 아니면 encrypted의 주소를 돌려준다.
+    */
+    const seal::Ciphertext *align(
+        const seal::Ciphertext &encrypted, seal::parms_id_type parms_id, seal::Ciphertext &aligned) const;
+
+    const seal::Evaluator &evaluator_;
+
+    const seal::RelinKeys &relin_keys_;
+
+    ScaleManager scales_;
+
+    mutable std::atomic<std::size_t> mod_switch_count_{ 0 };
+
+    mutable std::atomic<std::size_t> dropped_levels_{ 0 };
+
+    mutable std::atomic<std::size_t> scale_fix_count_{ 0 };
+};
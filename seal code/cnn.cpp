@@ -0,0 +1,950 @@
+#include "cnn.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+vector<double> pack_feature_map(const vector<vector<vector<double>>> &maps)
+{
+    vector<double> result;
+    for (const auto &channel : maps)
+    {
+        for (const auto &row : channel)
+        {
+            if (row.size() != channel.front().size())
+            {
+                throw invalid_argument("feature map rows must have the same width");
+            }
+            result.insert(result.end(), row.begin(), row.end());
+        }
+    }
+    return result;
+}
+
+namespace
+{
+    void check_conv2d_shape(const Conv2dShape &shape, size_t slot_count)
+    {
+        const FeatureMapShape &input = shape.input;
+        if (input.channels == 0 || shape.output_channels == 0 || shape.kernel_size == 0 || shape.stride == 0)
+        {
+            throw invalid_argument("conv2d channels, kernel_size and stride must be positive");
+        }
+        if (shape.kernel_size > input.height + 2 * shape.padding ||
+            shape.kernel_size > input.width + 2 * shape.padding)
+        {
+            throw invalid_argument("kernel is larger than the padded feature map");
+        }
+        if (2 * shape.padding > shape.kernel_size - 1)
+        {
+            throw invalid_argument("padding must be at most (kernel_size - 1) / 2");
+        }
+        if (shape.input_blocks() * input.height * input.width > slot_count)
+        {
+            throw invalid_argument("(output_channels + channels - 1) * height * width exceeds slot_count");
+        }
+    }
+
+    // 탭 (row, col)이 출력 위치 (r, c)에서 읽는 입력 슬롯까지의 거리
+    int tap_offset(const Conv2dShape &shape, size_t row, size_t col)
+    {
+        int width = static_cast<int>(shape.input.width);
+        int padding = static_cast<int>(shape.padding);
+        return (static_cast<int>(row) - padding) * width + (static_cast<int>(col) - padding);
+    }
+
+    bool is_zero(const vector<double> &values)
+    {
+        return all_of(values.begin(), values.end(), [](double v) { return v == 0.0; });
+    }
+
+    double next_rescale_prime(const SEALContext &context, parms_id_type parms_id)
+    {
+        auto context_data = context.get_context_data(parms_id);
+        return static_cast<double>(context_data->parms().coeff_modulus().back().value());
+    }
+} // namespace
+
+vector<double> replicate_channels(const Conv2dShape &shape, const vector<double> &packed_input, size_t slot_count)
+{
+    check_conv2d_shape(shape, slot_count);
+    size_t block = shape.input.height * shape.input.width;
+    if (packed_input.size() != shape.input.size())
+    {
+        throw invalid_argument("packed input does not match the feature map shape");
+    }
+
+    vector<double> result(slot_count, 0.0);
+    for (size_t b = 0; b < shape.input_blocks(); b++)
+    {
+        size_t channel = b % shape.input.channels;
+        copy(
+            packed_input.begin() + channel * block, packed_input.begin() + (channel + 1) * block,
+            result.begin() + b * block);
+    }
+    return result;
+}
+
+WeightCache make_conv2d_weights(const CKKSEncoder &encoder, const Conv2dShape &shape, const ConvKernel &kernel)
+{
+    size_t slot_count = encoder.slot_count();
+    check_conv2d_shape(shape, slot_count);
+    const FeatureMapShape &input = shape.input;
+    size_t k = shape.kernel_size;
+    if (kernel.size() != shape.output_channels)
+    {
+        throw invalid_argument("kernel does not match output_channels");
+    }
+    for (const auto &per_output : kernel)
+    {
+        if (per_output.size() != input.channels)
+        {
+            throw invalid_argument("kernel does not match input channels");
+        }
+        for (const auto &taps : per_output)
+        {
+            if (taps.size() != k || any_of(taps.begin(), taps.end(), [&](const vector<double> &r) {
+                    return r.size() != k;
+                }))
+            {
+                throw invalid_argument("kernel taps must be kernel_size x kernel_size");
+            }
+        }
+    }
+
+    size_t block = input.height * input.width;
+    size_t out_height = shape.output_height();
+    size_t out_width = shape.output_width();
+    vector<vector<double>> weights(input.channels * k * k, vector<double>(slot_count, 0.0));
+    for (size_t j = 0; j < input.channels; j++)
+    {
+        for (size_t row = 0; row < k; row++)
+        {
+            for (size_t col = 0; col < k; col++)
+            {
+                auto &plain = weights[(j * k + row) * k + col];
+                for (size_t o = 0; o < shape.output_channels; o++)
+                {
+                    double w = kernel[o][(o + j) % input.channels][row][col];
+                    for (size_t i = 0; i < out_height; i++)
+                    {
+                        // padding 밖(0)을 읽는 탭은 가린다
+                        size_t r = i * shape.stride;
+                        if (r + row < shape.padding || r + row - shape.padding >= input.height)
+                        {
+                            continue;
+                        }
+                        for (size_t t = 0; t < out_width; t++)
+                        {
+                            size_t c = t * shape.stride;
+                            if (c + col < shape.padding || c + col - shape.padding >= input.width)
+                            {
+                                continue;
+                            }
+                            // giant step 회전 j * block을 상쇄하도록 미리 회전
+                            plain[(input.slot(o, r, c) + j * block) % slot_count] = w;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return WeightCache(encoder, move(weights));
+}
+
+bool conv2d_fits(const Conv2dShape &shape, size_t slot_count)
+{
+    try
+    {
+        check_conv2d_shape(shape, slot_count);
+    }
+    catch (const invalid_argument &)
+    {
+        return false;
+    }
+    return true;
+}
+
+vector<vector<double>> conv2d_matrix(const Conv2dShape &shape, const ConvKernel &kernel)
+{
+    const FeatureMapShape &input = shape.input;
+    FeatureMapShape output{ shape.output_channels, shape.output_height(), shape.output_width() };
+    if (kernel.size() != shape.output_channels)
+    {
+        throw invalid_argument("kernel does not match output_channels");
+    }
+
+    vector<vector<double>> matrix(output.size(), vector<double>(input.size(), 0.0));
+    for (size_t o = 0; o < output.channels; o++)
+    {
+        for (size_t i = 0; i < output.height; i++)
+        {
+            for (size_t j = 0; j < output.width; j++)
+            {
+                auto &row = matrix[output.slot(o, i, j)];
+                for (size_t c = 0; c < input.channels; c++)
+                {
+                    for (size_t dr = 0; dr < shape.kernel_size; dr++)
+                    {
+                        for (size_t dc = 0; dc < shape.kernel_size; dc++)
+                        {
+                            size_t r = i * shape.stride + dr;
+                            size_t col = j * shape.stride + dc;
+                            if (r < shape.padding || col < shape.padding || r - shape.padding >= input.height ||
+                                col - shape.padding >= input.width)
+                            {
+                                continue;
+                            }
+                            row[input.slot(c, r - shape.padding, col - shape.padding)] += kernel.at(o).at(c).at(dr).at(dc);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return matrix;
+}
+
+vector<int> conv2d_steps(const Conv2dShape &shape)
+{
+    vector<int> steps;
+    for (size_t row = 0; row < shape.kernel_size; row++)
+    {
+        for (size_t col = 0; col < shape.kernel_size; col++)
+        {
+            int offset = tap_offset(shape, row, col);
+            if (offset != 0)
+            {
+                steps.push_back(offset);
+            }
+        }
+    }
+    size_t block = shape.input.height * shape.input.width;
+    for (size_t j = 1; j < shape.input.channels; j++)
+    {
+        steps.push_back(static_cast<int>(j * block));
+    }
+    return steps;
+}
+
+size_t conv2d_rotation_count(const Conv2dShape &shape)
+{
+    return conv2d_steps(shape).size();
+}
+
+void conv2d(
+    const SEALContext &context, const Evaluator &evaluator, const GaloisKeys &galois_keys, const Conv2dShape &shape,
+    const WeightCache &weights, const Ciphertext &encrypted, Ciphertext &destination)
+{
+    size_t taps = shape.kernel_size * shape.kernel_size;
+    if (weights.size() != shape.input.channels * taps)
+    {
+        throw invalid_argument("weights do not match the conv2d shape");
+    }
+    const auto &plains = weights.get(encrypted.parms_id(), next_rescale_prime(context, encrypted.parms_id()));
+
+    // 탭 회전은 한 번만 계산해 모든 채널 오프셋이 같이 쓴다
+    MemoryPoolHandle pool = MemoryManager::GetPool();
+    vector<Ciphertext> tap_rotations(taps);
+    for (size_t t = 0; t < taps; t++)
+    {
+        int offset = tap_offset(shape, t / shape.kernel_size, t % shape.kernel_size);
+        if (offset == 0)
+        {
+            tap_rotations[t] = encrypted;
+        }
+        else
+        {
+            evaluator.rotate_vector(encrypted, offset, galois_keys, tap_rotations[t], pool);
+        }
+    }
+
+    size_t block = shape.input.height * shape.input.width;
+    Ciphertext sum;
+    Ciphertext inner;
+    Ciphertext term;
+    bool has_sum = false;
+    for (size_t j = 0; j < shape.input.channels; j++)
+    {
+        // 모두 0인 가중치(가지치기된 커널 등)는 건너뛴다
+        bool has_inner = false;
+        for (size_t t = 0; t < taps; t++)
+        {
+            if (is_zero(weights.values(j * taps + t)))
+            {
+                continue;
+            }
+            evaluator.multiply_plain(tap_rotations[t], plains[j * taps + t], has_inner ? term : inner, pool);
+            if (has_inner)
+            {
+                evaluator.add_inplace(inner, term);
+            }
+            has_inner = true;
+        }
+        if (!has_inner)
+        {
+            continue;
+        }
+
+        // 채널 오프셋: 탭을 모두 더한 뒤 한 번만 회전
+        if (j != 0)
+        {
+            evaluator.rotate_vector_inplace(inner, static_cast<int>(j * block), galois_keys, pool);
+        }
+        if (has_sum)
+        {
+            evaluator.add_inplace(sum, inner);
+        }
+        else
+        {
+            sum = move(inner);
+            has_sum = true;
+        }
+    }
+    if (!has_sum)
+    {
+        throw invalid_argument("conv2d kernel is all zero");
+    }
+    evaluator.rescale_to_next_inplace(sum, pool);
+    destination = move(sum);
+}
+
+vector<size_t> max_pool_offsets(size_t window)
+{
+    if (window == 0)
+    {
+        throw invalid_argument("window must be positive");
+    }
+    vector<size_t> offsets;
+    for (size_t covered = 1; covered < window;)
+    {
+        size_t offset = min(covered, window - covered);
+        offsets.push_back(offset);
+        covered += offset;
+    }
+    return offsets;
+}
+
+vector<int> max_pool_steps(const FeatureMapShape &shape, size_t window)
+{
+    vector<int> steps;
+    for (size_t offset : max_pool_offsets(window))
+    {
+        steps.push_back(static_cast<int>(offset));
+        steps.push_back(static_cast<int>(offset * shape.width));
+    }
+    return steps;
+}
+
+size_t max_pool_rounds(size_t window)
+{
+    return 2 * max_pool_offsets(window).size();
+}
+
+size_t max_pool_depth(const SignConfig &config, size_t window)
+{
+    return max_pool_rounds(window) * max_circuit_depth(config);
+}
+
+void max_pool(
+    const Comparator &comparator, const Evaluator &evaluator, const GaloisKeys &galois_keys,
+    const FeatureMapShape &shape, size_t window, const Ciphertext &encrypted, Ciphertext &destination)
+{
+    if (window > shape.height || window > shape.width)
+    {
+        throw invalid_argument("window is larger than the feature map");
+    }
+
+    Ciphertext current = encrypted;
+    Ciphertext rotated;
+    for (size_t stride : { size_t(1), shape.width })
+    {
+        for (size_t offset : max_pool_offsets(window))
+        {
+            evaluator.rotate_vector(current, static_cast<int>(offset * stride), galois_keys, rotated);
+            comparator.max(current, rotated, current);
+        }
+    }
+    destination = move(current);
+}
+
+namespace
+{
+    // sum_k coeffs[k] * T_k(t)를 단항식 계수로 바꾼다 (T_(k+1) = 2t T_k - T_(k-1))
+    vector<double> chebyshev_to_monomial(const vector<double> &coeffs)
+    {
+        size_t n = coeffs.size();
+        vector<double> result(n, 0.0);
+        vector<double> previous(n, 0.0), current(n, 0.0), next(n, 0.0);
+        previous[0] = 1.0;
+        if (n > 1)
+        {
+            current[1] = 1.0;
+        }
+        for (size_t k = 0; k < n; k++)
+        {
+            const vector<double> &basis = (k == 0) ? previous : current;
+            for (size_t i = 0; i < n; i++)
+            {
+                result[i] += coeffs[k] * basis[i];
+            }
+            if (k >= 1 && k + 1 < n)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    next[i] = (i > 0 ? 2.0 * current[i - 1] : 0.0) - previous[i];
+                }
+                previous.swap(current);
+                current.swap(next);
+            }
+        }
+        return result;
+    }
+
+    // [-1, 1]의 Chebyshev 노드 points개에서 max(t, 0)의 차수 degree 최소제곱 (이산 Chebyshev 급수의 앞부분)
+    vector<double> relu_least_squares(size_t degree)
+    {
+        const double pi = acos(-1.0);
+        const size_t points = 512;
+        vector<double> coeffs(degree + 1, 0.0);
+        for (size_t k = 0; k <= degree; k++)
+        {
+            double sum = 0.0;
+            for (size_t j = 0; j < points; j++)
+            {
+                double angle = pi * (static_cast<double>(j) + 0.5) / static_cast<double>(points);
+                sum += max(cos(angle), 0.0) * cos(static_cast<double>(k) * angle);
+            }
+            coeffs[k] = (k == 0 ? 1.0 : 2.0) * sum / static_cast<double>(points);
+        }
+        return chebyshev_to_monomial(coeffs);
+    }
+
+    double evaluate_plain(const vector<double> &coeffs, double x)
+    {
+        double result = 0.0;
+        for (size_t i = coeffs.size(); i-- > 0;)
+        {
+            result = result * x + coeffs[i];
+        }
+        return result;
+    }
+} // namespace
+
+ReluApproximation make_relu_approximation(ReluPreset preset, double bound, size_t degree, int precision_bits)
+{
+    if (!(bound > 0.0))
+    {
+        throw invalid_argument("bound must be positive");
+    }
+
+    ReluApproximation result{ preset, bound, {}, SignConfig{ 0, 0, 0, 0, 0 }, false, 0 };
+    if (preset == ReluPreset::composite)
+    {
+        // relu 오차는 bound * |t| * |1 - sign 근사| / 2 (t = x / bound)이므로 log2(bound) 비트 더 정확하게
+        int extra_bits = max(0, static_cast<int>(ceil(log2(bound))));
+        result.sign = choose_max_config(precision_bits + extra_bits);
+        result.depth = relu_depth(result.sign, bound);
+        result.prescale = result.depth > max_circuit_depth(result.sign);
+        return result;
+    }
+
+    if (preset == ReluPreset::square)
+    {
+        degree = 2;
+    }
+    if (degree < 2)
+    {
+        throw invalid_argument("degree must be at least 2");
+    }
+
+    // p(x) = bound * q(x / bound)
+    result.coeffs = relu_least_squares(degree);
+    result.prescale = !can_fold_input_scale(bound, degree);
+    double power = bound;
+    for (double &c : result.coeffs)
+    {
+        c *= power;
+        if (!result.prescale)
+        {
+            power /= bound;
+        }
+    }
+    result.depth = choose_paterson_stockmeyer(degree, true).depth + (result.prescale ? 1 : 0);
+    return result;
+}
+
+double relu_plain_error(const ReluApproximation &approximation, size_t points)
+{
+    if (points < 2)
+    {
+        throw invalid_argument("points must be at least 2");
+    }
+
+    vector<double> f, g;
+    if (approximation.preset == ReluPreset::composite)
+    {
+        f = sign_f_coefficients(approximation.sign.f_n);
+        g = sign_g_coefficients(approximation.sign.g_n);
+    }
+    double bound = approximation.bound;
+    double error = 0.0;
+    for (size_t i = 0; i < points; i++)
+    {
+        double x = -bound + 2.0 * bound * static_cast<double>(i) / static_cast<double>(points - 1);
+        double value;
+        if (approximation.preset == ReluPreset::composite)
+        {
+            double s = x / bound;
+            for (size_t t = 0; t < approximation.sign.g_iterations; t++)
+            {
+                s = evaluate_plain(g, s);
+            }
+            for (size_t t = 0; t < approximation.sign.f_iterations; t++)
+            {
+                s = evaluate_plain(f, s);
+            }
+            value = x * (1.0 + s) / 2.0;
+        }
+        else
+        {
+            value = evaluate_plain(approximation.coeffs, approximation.prescale ? x / bound : x);
+        }
+        error = max(error, fabs(value - max(x, 0.0)));
+    }
+    return error;
+}
+
+double relu_value_bound(const ReluApproximation &approximation)
+{
+    double bound = approximation.bound;
+    if (approximation.preset == ReluPreset::composite)
+    {
+        return max(bound, 1.0) * sign_value_bound(approximation.sign);
+    }
+
+    // Paterson-Stockmeyer 블록의 합은 sum |c_i| r^i 이하 (r은 다항식 입력의 상한)
+    double input_bound = approximation.prescale ? 1.0 : bound;
+    double sum = 0.0;
+    double power = 1.0;
+    for (double c : approximation.coeffs)
+    {
+        sum += fabs(c) * power;
+        power *= input_bound;
+    }
+    return max(sum, bound);
+}
+
+ReluLayer::ReluLayer(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys,
+    const ReluApproximation &approximation)
+    : approximation_(approximation), polynomial_evaluator_(context, evaluator, encoder, relin_keys)
+{
+    if (approximation_.preset == ReluPreset::composite)
+    {
+        comparator_.reset(new Comparator(context, evaluator, encoder, relin_keys, approximation_.sign));
+    }
+}
+
+void ReluLayer::apply(const Ciphertext &encrypted, Ciphertext &destination) const
+{
+    if (comparator_)
+    {
+        comparator_->relu(encrypted, approximation_.bound, destination);
+        return;
+    }
+
+    const Ciphertext *input = &encrypted;
+    Ciphertext scaled;
+    if (approximation_.prescale)
+    {
+        const ScaleManager &scales = polynomial_evaluator_.aligned().scales();
+        size_t index = scales.chain_index(encrypted.parms_id());
+        if (index < approximation_.depth)
+        {
+            throw invalid_argument("not enough levels to apply relu");
+        }
+        scales.multiply_const(
+            encrypted, 1.0 / approximation_.bound, scales.parms_id_at(index - 1), encrypted.scale(), scaled);
+        input = &scaled;
+    }
+
+    PatersonStockmeyerBasis basis;
+    polynomial_evaluator_.compute_paterson_stockmeyer_basis(
+        *input, choose_paterson_stockmeyer(approximation_.coeffs.size() - 1, true), basis);
+    polynomial_evaluator_.evaluate_paterson_stockmeyer(basis, approximation_.coeffs, destination);
+}
+
+namespace
+{
+    void check_small_cnn(const SmallCnn &model)
+    {
+        const Conv2dShape &conv = model.conv;
+        if (conv.input.size() == 0 || conv.output_channels == 0 || conv.kernel_size == 0 || conv.stride == 0 ||
+            conv.kernel_size > conv.input.height + 2 * conv.padding ||
+            conv.kernel_size > conv.input.width + 2 * conv.padding)
+        {
+            throw invalid_argument("invalid conv shape");
+        }
+        if (model.conv_kernel.size() != conv.output_channels || model.conv_bias.size() != conv.output_channels)
+        {
+            throw invalid_argument("conv kernel and bias must have output_channels entries");
+        }
+        for (const auto &per_output : model.conv_kernel)
+        {
+            if (per_output.size() != conv.input.channels)
+            {
+                throw invalid_argument("conv kernel does not match input channels");
+            }
+            for (const auto &taps : per_output)
+            {
+                if (taps.size() != conv.kernel_size ||
+                    any_of(taps.begin(), taps.end(), [&](const vector<double> &r) { return r.size() != conv.kernel_size; }))
+                {
+                    throw invalid_argument("conv kernel taps must be kernel_size x kernel_size");
+                }
+            }
+        }
+        if (model.pool_window == 0 || model.pooled_shape().size() == 0)
+        {
+            throw invalid_argument("pool window must be positive and at most the conv output size");
+        }
+        if (model.dense.empty() || model.dense_bias.size() != model.dense.size())
+        {
+            throw invalid_argument("dense weights and bias must have the same number of classes");
+        }
+        for (const auto &row : model.dense)
+        {
+            if (row.size() != model.pooled_shape().size())
+            {
+                throw invalid_argument("dense weights do not match the pooled features");
+            }
+        }
+    }
+
+    // 출력 (i, j)의 탭 (row, col)이 읽는 입력 좌표. padding 밖이면 false
+    bool conv_source(const Conv2dShape &conv, size_t i, size_t j, size_t row, size_t col, size_t &r, size_t &c)
+    {
+        r = i * conv.stride + row;
+        c = j * conv.stride + col;
+        if (r < conv.padding || c < conv.padding || r - conv.padding >= conv.input.height ||
+            c - conv.padding >= conv.input.width)
+        {
+            return false;
+        }
+        r -= conv.padding;
+        c -= conv.padding;
+        return true;
+    }
+
+    vector<double> flatten_conv_kernel(const SmallCnn &model)
+    {
+        vector<double> result;
+        for (const auto &per_output : model.conv_kernel)
+        {
+            for (const auto &taps : per_output)
+            {
+                for (const auto &row : taps)
+                {
+                    result.insert(result.end(), row.begin(), row.end());
+                }
+            }
+        }
+        return result;
+    }
+
+    // 평균 pooling의 1 / window^2를 dense 가중치에 합친다
+    vector<double> flatten_dense(const SmallCnn &model)
+    {
+        double pool_scale = 1.0 / static_cast<double>(model.pool_window * model.pool_window);
+        vector<double> result;
+        for (const auto &row : model.dense)
+        {
+            for (double w : row)
+            {
+                result.push_back(w * pool_scale);
+            }
+        }
+        return result;
+    }
+} // namespace
+
+vector<double> evaluate_small_cnn(const SmallCnn &model, const vector<double> &image, double *max_abs)
+{
+    check_small_cnn(model);
+    const Conv2dShape &conv = model.conv;
+    if (image.size() != conv.input.size())
+    {
+        throw invalid_argument("image does not match the input shape");
+    }
+
+    double largest = 0.0;
+    auto track = [&](double v) {
+        largest = max(largest, fabs(v));
+        return v;
+    };
+    for (double v : image)
+    {
+        track(v);
+    }
+
+    FeatureMapShape conv_shape = model.conv_output_shape();
+    vector<double> activated(conv_shape.size());
+    for (size_t o = 0; o < conv_shape.channels; o++)
+    {
+        for (size_t i = 0; i < conv_shape.height; i++)
+        {
+            for (size_t j = 0; j < conv_shape.width; j++)
+            {
+                double sum = model.conv_bias[o];
+                for (size_t c = 0; c < conv.input.channels; c++)
+                {
+                    for (size_t row = 0; row < conv.kernel_size; row++)
+                    {
+                        for (size_t col = 0; col < conv.kernel_size; col++)
+                        {
+                            size_t r, s;
+                            if (conv_source(conv, i, j, row, col, r, s))
+                            {
+                                sum += model.conv_kernel[o][c][row][col] * image[conv.input.slot(c, r, s)];
+                            }
+                        }
+                    }
+                }
+                activated[conv_shape.slot(o, i, j)] = track(track(sum) * sum);
+            }
+        }
+    }
+
+    FeatureMapShape pooled_shape = model.pooled_shape();
+    size_t w = model.pool_window;
+    vector<double> pooled(pooled_shape.size());
+    for (size_t o = 0; o < pooled_shape.channels; o++)
+    {
+        for (size_t i = 0; i < pooled_shape.height; i++)
+        {
+            for (size_t j = 0; j < pooled_shape.width; j++)
+            {
+                double sum = 0.0;
+                for (size_t di = 0; di < w; di++)
+                {
+                    for (size_t dj = 0; dj < w; dj++)
+                    {
+                        sum += activated[conv_shape.slot(o, i * w + di, j * w + dj)];
+                    }
+                }
+                // 암호문에서는 나누기 전의 합을 갖고 있다
+                track(sum);
+                pooled[pooled_shape.slot(o, i, j)] = sum / static_cast<double>(w * w);
+            }
+        }
+    }
+
+    vector<double> result(model.dense.size());
+    for (size_t k = 0; k < model.dense.size(); k++)
+    {
+        double sum = model.dense_bias[k];
+        for (size_t f = 0; f < pooled.size(); f++)
+        {
+            sum += model.dense[k][f] * pooled[f];
+        }
+        result[k] = track(sum);
+    }
+    if (max_abs)
+    {
+        *max_abs = largest;
+    }
+    return result;
+}
+
+void encrypt_image_batch(
+    const CKKSEncoder &encoder, const Encryptor &encryptor, const vector<vector<double>> &images, double scale,
+    vector<Ciphertext> &destination, const ParallelExecutor &executor)
+{
+    if (images.empty() || images.size() > encoder.slot_count())
+    {
+        throw invalid_argument("batch size must be between 1 and slot_count");
+    }
+    size_t pixels = images[0].size();
+    for (const auto &image : images)
+    {
+        if (image.size() != pixels)
+        {
+            throw invalid_argument("images must have the same size");
+        }
+    }
+
+    vector<Ciphertext> result(pixels);
+    executor.run(pixels, [&](size_t p, const MemoryPoolHandle &pool) {
+        vector<double> slots(images.size());
+        for (size_t b = 0; b < images.size(); b++)
+        {
+            slots[b] = images[b][p];
+        }
+        Plaintext plain;
+        encoder.encode(slots, scale, plain, pool);
+        encryptor.encrypt(plain, result[p], pool);
+    });
+    destination = move(result);
+}
+
+vector<vector<double>> decrypt_image_batch(
+    const CKKSEncoder &encoder, Decryptor &decryptor, const vector<Ciphertext> &encrypted, size_t batch_size)
+{
+    vector<vector<double>> result(batch_size, vector<double>(encrypted.size()));
+    Plaintext plain;
+    vector<double> slots;
+    for (size_t k = 0; k < encrypted.size(); k++)
+    {
+        decryptor.decrypt(encrypted[k], plain);
+        encoder.decode(plain, slots);
+        for (size_t b = 0; b < batch_size && b < slots.size(); b++)
+        {
+            result[b][k] = slots[b];
+        }
+    }
+    return result;
+}
+
+BatchedCnn::BatchedCnn(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys,
+    const SmallCnn &model)
+    : context_(context), evaluator_(evaluator), relin_keys_(relin_keys), model_(model),
+      conv_weights_(encoder, flatten_conv_kernel(model)), conv_bias_(encoder, model.conv_bias),
+      dense_weights_(encoder, flatten_dense(model)), dense_bias_(encoder, model.dense_bias)
+{
+    check_small_cnn(model_);
+}
+
+void BatchedCnn::prepare() const
+{
+    conv_weights_.prepare_rescale_levels(context_);
+    dense_weights_.prepare_rescale_levels(context_);
+}
+
+void BatchedCnn::infer(
+    const vector<Ciphertext> &pixels, vector<Ciphertext> &destination, const ParallelExecutor &executor) const
+{
+    const Conv2dShape &conv = model_.conv;
+    if (pixels.size() != conv.input.size())
+    {
+        throw invalid_argument("pixel ciphertexts do not match the input shape");
+    }
+    parms_id_type parms_id = pixels[0].parms_id();
+    if (context_.get_context_data(parms_id)->chain_index() < depth())
+    {
+        throw invalid_argument("not enough levels for batched inference");
+    }
+
+    // conv + bias + x^2: 출력 뉴런마다 스칼라 가중합 한 번, rescale 한 번, 제곱 한 번
+    FeatureMapShape conv_shape = model_.conv_output_shape();
+    size_t k = conv.kernel_size;
+    const auto &conv_plains = conv_weights_.get(parms_id, next_rescale_prime(context_, parms_id));
+    vector<Ciphertext> activated(conv_shape.size());
+    executor.run(conv_shape.size(), [&](size_t index, const MemoryPoolHandle &pool) {
+        size_t o = index / (conv_shape.height * conv_shape.width);
+        size_t i = (index / conv_shape.width) % conv_shape.height;
+        size_t j = index % conv_shape.width;
+
+        Ciphertext sum;
+        Ciphertext term;
+        bool first = true;
+        for (size_t c = 0; c < conv.input.channels; c++)
+        {
+            for (size_t row = 0; row < k; row++)
+            {
+                for (size_t col = 0; col < k; col++)
+                {
+                    size_t weight = ((o * conv.input.channels + c) * k + row) * k + col;
+                    size_t r, s;
+                    // 0인 가중치는 곱하지 않는다 (결과가 투명한 암호문이 된다)
+                    if (!conv_source(conv, i, j, row, col, r, s) || conv_weights_.values(weight)[0] == 0.0)
+                    {
+                        continue;
+                    }
+                    evaluator_.multiply_plain(
+                        pixels[conv.input.slot(c, r, s)], conv_plains[weight], first ? sum : term, pool);
+                    if (!first)
+                    {
+                        evaluator_.add_inplace(sum, term);
+                    }
+                    first = false;
+                }
+            }
+        }
+        if (first)
+        {
+            throw invalid_argument("conv output does not depend on the input");
+        }
+        evaluator_.rescale_to_next_inplace(sum, pool);
+        evaluator_.add_plain_inplace(sum, conv_bias_.get(sum.parms_id(), sum.scale())[o]);
+        evaluator_.square_inplace(sum, pool);
+        evaluator_.relinearize_inplace(sum, relin_keys_, pool);
+        evaluator_.rescale_to_next_inplace(sum, pool);
+        activated[index] = move(sum);
+    });
+
+    // 평균 pooling: 창의 합만 구한다 (1 / window^2는 dense 가중치에 들어 있다)
+    FeatureMapShape pooled_shape = model_.pooled_shape();
+    size_t w = model_.pool_window;
+    vector<Ciphertext> pooled(pooled_shape.size());
+    for (size_t o = 0; o < pooled_shape.channels; o++)
+    {
+        for (size_t i = 0; i < pooled_shape.height; i++)
+        {
+            for (size_t j = 0; j < pooled_shape.width; j++)
+            {
+                Ciphertext &sum = pooled[pooled_shape.slot(o, i, j)];
+                for (size_t di = 0; di < w; di++)
+                {
+                    for (size_t dj = 0; dj < w; dj++)
+                    {
+                        const Ciphertext &value = activated[conv_shape.slot(o, i * w + di, j * w + dj)];
+                        if (di == 0 && dj == 0)
+                        {
+                            sum = value;
+                        }
+                        else
+                        {
+                            evaluator_.add_inplace(sum, value);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // dense + bias
+    size_t features = pooled.size();
+    parms_id_type pooled_parms_id = pooled[0].parms_id();
+    const auto &dense_plains = dense_weights_.get(pooled_parms_id, next_rescale_prime(context_, pooled_parms_id));
+    vector<Ciphertext> result(model_.dense.size());
+    executor.run(result.size(), [&](size_t c, const MemoryPoolHandle &pool) {
+        Ciphertext sum;
+        Ciphertext term;
+        bool first = true;
+        for (size_t f = 0; f < features; f++)
+        {
+            if (dense_weights_.values(c * features + f)[0] == 0.0)
+            {
+                continue;
+            }
+            evaluator_.multiply_plain(pooled[f], dense_plains[c * features + f], first ? sum : term, pool);
+            if (!first)
+            {
+                evaluator_.add_inplace(sum, term);
+            }
+            first = false;
+        }
+        if (first)
+        {
+            throw invalid_argument("dense output does not depend on the input");
+        }
+        evaluator_.rescale_to_next_inplace(sum, pool);
+        evaluator_.add_plain_inplace(sum, dense_bias_.get(sum.parms_id(), sum.scale())[c]);
+        result[c] = move(sum);
+    });
+    destination = move(result);
+}
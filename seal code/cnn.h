@@ -0,0 +1,345 @@
+#pragma once
+
+#include "comparison.h"
+#include "parallel.h"
+#include "polynomial.h"
+#include "seal/seal.h"
+#include "weight_cache.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+암호화된 CNN 층 모음.
+특징 맵은 채널마다 height x width를 행 우선으로 펼쳐 이어 붙인다: (channel, row, col) -> 슬롯
+channel * height * width + row * width + col.
+*/
+struct FeatureMapShape
+{
+    std::size_t channels;
+    std::size_t height;
+    std::size_t width;
+
+    std::size_t size() const
+    {
+        return channels * height * width;
+    }
+
+    std::size_t slot(std::size_t channel, std::size_t row, std::size_t col) const
+    {
+        return (channel * height + row) * width + col;
+    }
+};
+
+/*
+Helper function: 값들을 FeatureMapShape 순서로 펼친다. maps[channel][row][col].
+*/
+std::vector<double> pack_feature_map(const std::vector<std::vector<std::vector<double>>> &maps);
+
+/*
+2차원 합성곱 층의 모양. 출력 크기는 (height + 2 padding - kernel_size) / stride + 1.
+padding은 (kernel_size - 1) / 2 이하여야 한다 (출력 좌표 (i, j)를 입력 격자의 (i * stride, j * stride)에 두므로).
+*/
+struct Conv2dShape
+{
+    FeatureMapShape input;
+    std::size_t output_channels;
+    std::size_t kernel_size;
+    std::size_t stride;
+    std::size_t padding;
+
+    std::size_t output_height() const
+    {
+        return (input.height + 2 * padding - kernel_size) / stride + 1;
+    }
+
+    std::size_t output_width() const
+    {
+        return (input.width + 2 * padding - kernel_size) / stride + 1;
+    }
+
+    // 입력 채널을 복제해 두어야 하는 블록 수 (블록 하나는 height * width 슬롯)
+    std::size_t input_blocks() const
+    {
+        return output_channels + input.channels - 1;
+    }
+
+    /*
+    출력 (channel, i, j)가 들어 있는 슬롯. 출력 채널 o는 블록 o에 입력과 같은 격자로 놓이며
+    stride 배수 위치만 값이 있고 나머지 슬롯은 0이다.
+    */
+    std::size_t output_slot(std::size_t channel, std::size_t i, std::size_t j) const
+    {
+        return input.slot(channel, i * stride, j * stride);
+    }
+};
+
+/*
+합성곱 커널. kernel[output_channel][input_channel][row][col].
+*/
+using ConvKernel = std::vector<std::vector<std::vector<std::vector<double>>>>;
+
+/*
+Helper function: pack_feature_map으로 펼친 입력을 conv2d 입력 형식으로 만든다.
+블록 b (b < input_blocks())에 채널 b mod channels를 두고 나머지 슬롯은 0으로 채운다 (replicate_vector와 같은 역할).
+*/
+std::vector<double> replicate_channels(
+    const Conv2dShape &shape, const std::vector<double> &packed_input, std::size_t slot_count);
+
+/*
+Helper function: conv2d에 쓸 마스크된 가중치 평문 값. 채널 오프셋 j와 탭 t = row * kernel_size + col마다 하나씩
+(인덱스 j * kernel_size^2 + t), 블록 o에 kernel[o][(o + j) mod channels][row][col]을 채우고
+padding 밖을 읽거나 stride 배수가 아닌 출력 위치는 0으로 가린다. giant step 회전 j * height * width를 상쇄하도록
+make_bsgs_weights처럼 평문에서 미리 회전해 둔다.
+*/
+WeightCache make_conv2d_weights(const seal::CKKSEncoder &encoder, const Conv2dShape &shape, const ConvKernel &kernel);
+
+/*
+Helper function: shape가 conv2d의 조건(padding, 슬롯 수)을 만족하는지.
+*/
+bool conv2d_fits(const Conv2dShape &shape, std::size_t slot_count);
+
+/*
+Helper function: 합성곱을 행렬로 펼친다. 행은 (output_channels, output_height, output_width)의 FeatureMapShape 순서,
+열은 입력의 FeatureMapShape 순서이며 padding 밖은 0으로 본다. conv2d를 쓸 수 없을 때 행렬-벡터 곱으로 계산할 때 쓴다.
+*/
+std::vector<std::vector<double>> conv2d_matrix(const Conv2dShape &shape, const ConvKernel &kernel);
+
+/*
+Helper function: conv2d에 필요한 Galois 키 step (RotationKeyPlanner::add_step에 넘긴다).
+*/
+std::vector<int> conv2d_steps(const Conv2dShape &shape);
+
+/*
+Helper function: conv2d의 회전 횟수. 탭 회전 kernel_size^2 - 1번과 채널 오프셋 회전 channels - 1번.
+*/
+std::size_t conv2d_rotation_count(const Conv2dShape &shape);
+
+/*
+패킹된 2차원 합성곱. encrypted는 replicate_channels로 만든 입력을 암호화한 것이다.
+out = sum_j rot_(j * height * width)( sum_t rot_(delta_t)(x) * P_(j, t) ), delta_t = (row - padding) * width + (col - padding).
+탭 회전 rot_(delta_t)(x)는 한 번만 계산해 모든 채널 오프셋 j가 같이 쓰고 (BSGS의 baby step처럼),
+채널 오프셋마다 탭을 모두 더한 뒤 한 번만 회전한다. 출력 채널은 모두 한 암호문에서 동시에 누적된다.
+가중치는 현재 레벨의 마지막 소수를 scale로 인코딩하므로 레벨 하나를 쓰고 destination의 scale은 입력 scale과 같다.
+결과 위치는 Conv2dShape::output_slot.
+*/
+void conv2d(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const Conv2dShape &shape, const WeightCache &weights, const seal::Ciphertext &encrypted,
+    seal::Ciphertext &destination);
+
+/*
+Helper function: window 폭의 최댓값을 모으는 회전 step. 폭 s를 덮은 결과를 min(s, window - s)만큼 회전해
+max를 취하면 덮는 폭이 늘어나므로, ceil(log2 window)번이면 된다 (window = 3이면 1, 1).
+*/
+std::vector<std::size_t> max_pool_offsets(std::size_t window);
+
+/*
+Helper function: max_pool에 필요한 Galois 키 step (RotationKeyPlanner::add_step에 넘긴다).
+*/
+std::vector<int> max_pool_steps(const FeatureMapShape &shape, std::size_t window);
+
+/*
+Helper function: window x window max pooling의 max 토너먼트 라운드 수와 레벨 수.
+라운드마다 슬롯 전체의 max를 한 번에 계산하므로 라운드의 모든 비교가 같은 레벨을 함께 쓴다.
+두 값의 max로는 3 x 3 창의 9개를 ceil(log2 9) = 4라운드보다 얕게 모을 수 없고, 라운드마다
+max_circuit_depth(config) 레벨이 든다. 부트스트래핑 없이 N = 32768 파라미터 하나에 들어가는 것은
+2 x 2가 정밀도 8비트(24레벨), 3 x 3이 4비트(24레벨)까지이며, 그때는 conv, dense 층에 남는 레벨이 거의 없다
+(max_supported_depth로 미리 확인한다).
+*/
+std::size_t max_pool_rounds(std::size_t window);
+
+std::size_t max_pool_depth(const SignConfig &config, std::size_t window);
+
+/*
+window x window max pooling. 값은 [0, 1]이어야 한다 (ReLU 뒤의 활성값을 스케일한 것 등).
+가로로 max_pool_offsets만큼 회전해 max를 취해 각 슬롯이 (row, col ~ col + window - 1)의 최댓값을 갖게 하고,
+세로로 같은 일을 width 배수 회전으로 반복한다. 2 x 2는 라운드 2번, 3 x 3은 4번.
+결과는 모든 (row, col)에서 창의 최댓값을 계산한 것이며, row <= height - window, col <= width - window인
+슬롯만 의미가 있다 (stride s이면 row, col이 s의 배수인 슬롯을 읽는다).
+Comparator::max 오차가 라운드마다 더해지므로 오차는 max_pool_rounds(window)배까지 커진다.
+*/
+void max_pool(
+    const Comparator &comparator, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const FeatureMapShape &shape, std::size_t window, const seal::Ciphertext &encrypted,
+    seal::Ciphertext &destination);
+
+/*
+ReLU 근사 방식.
+square: [-bound, bound]에 맞춘 2차 최소제곱 (CryptoNets의 x^2 대신 범위에 맞춘 a + bx + cx^2). 레벨 2.
+least_squares: 차수 degree의 최소제곱. 차수를 올릴수록 오차는 줄고 레벨은 ceil(log2(degree + 1)).
+composite: 합성 sign으로 x (1 + sign(x)) / 2 (Comparator::relu). 원하는 정밀도까지 줄일 수 있지만 가장 깊다.
+*/
+enum class ReluPreset
+{
+    square,
+    least_squares,
+    composite
+};
+
+/*
+ReLU 근사 설정. 다항식 방식이면 coeffs는 x^0부터의 계수, composite이면 sign이 합성 설정이다.
+prescale이면 먼저 한 레벨을 써서 x / bound를 만들고 coeffs는 x / bound에 대한 계수,
+아니면 1 / bound를 coeffs에 합쳐 둔다 (can_fold_input_scale). depth는 prescale을 포함해 쓰는 레벨 수.
+*/
+struct ReluApproximation
+{
+    ReluPreset preset;
+    double bound;
+    std::vector<double> coeffs;
+    SignConfig sign;
+    bool prescale;
+    std::size_t depth;
+};
+
+/*
+Helper function: [-bound, bound]에서 ReLU를 근사하는 설정.
+least_squares는 degree (2 이상)를, composite은 절대 오차 2^-precision_bits를 쓴다.
+최소제곱은 [-1, 1]의 Chebyshev 노드에서 Chebyshev 급수로 구한 뒤 단항식 계수로 바꾸고 bound를 계수에 합친다.
+*/
+ReluApproximation make_relu_approximation(
+    ReluPreset preset, double bound, std::size_t degree = 2, int precision_bits = 8);
+
+/*
+Helper function: 평문에서 [-bound, bound]의 점 points개로 잰 |ReLU - 근사|의 최댓값.
+*/
+double relu_plain_error(const ReluApproximation &approximation, std::size_t points = 1001);
+
+/*
+Helper function: 근사를 계산하는 동안 암호문이 가질 수 있는 값의 절댓값 상한 (CircuitSpec::value_bound).
+*/
+double relu_value_bound(const ReluApproximation &approximation);
+
+/*
+패킹된 활성값 전체에 ReLU 근사를 적용하는 층. 다항식은 깊이가 가장 작은 Paterson-Stockmeyer 분할로 평가하고,
+결과의 scale은 입력 scale과 같다. approximation.depth 레벨을 쓴다.
+*/
+class ReluLayer
+{
+public:
+    ReluLayer(
+        const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+        const seal::RelinKeys &relin_keys, const ReluApproximation &approximation);
+
+    const ReluApproximation &approximation() const
+    {
+        return approximation_;
+    }
+
+    std::size_t depth() const
+    {
+        return approximation_.depth;
+    }
+
+    void apply(const seal::Ciphertext &encrypted, seal::Ciphertext &destination) const;
+
+private:
+    ReluApproximation approximation_;
+
+    PolynomialEvaluator polynomial_evaluator_;
+
+    // composite일 때만 만든다
+    std::unique_ptr<Comparator> comparator_;
+};
+
+/*
+CryptoNets 방식 배치 추론에 쓰는 작은 CNN (평문 모델):
+conv (가중합 + bias) -> x^2 -> window x window 평균 pooling (stride window) -> dense (+ bias).
+conv의 padding은 0으로 채운 것으로 본다. dense[class]는 pooled_shape() 순서로 펼친 특징에 곱한다.
+*/
+struct SmallCnn
+{
+    Conv2dShape conv;
+    ConvKernel conv_kernel;
+    std::vector<double> conv_bias;
+    std::size_t pool_window;
+    std::vector<std::vector<double>> dense;
+    std::vector<double> dense_bias;
+
+    FeatureMapShape conv_output_shape() const
+    {
+        return { conv.output_channels, conv.output_height(), conv.output_width() };
+    }
+
+    FeatureMapShape pooled_shape() const
+    {
+        return { conv.output_channels, conv.output_height() / pool_window, conv.output_width() / pool_window };
+    }
+};
+
+/*
+Helper function: 이미지 하나(pack_feature_map 순서)에 대한 평문 추론. 결과는 dense 출력 (logit).
+max_abs가 있으면 중간값을 포함한 절댓값의 최댓값을 넣는다 (CircuitSpec::value_bound).
+*/
+std::vector<double> evaluate_small_cnn(
+    const SmallCnn &model, const std::vector<double> &image, double *max_abs = nullptr);
+
+/*
+Helper function: 이미지 batch_size개(<= slot_count)를 픽셀마다 암호문 하나로 암호화한다.
+픽셀 p의 암호문은 슬롯 b에 images[b][p]를 담는다. 같은 연산을 모든 슬롯에 똑같이 적용하므로
+회전 없이 슬롯 수만큼의 이미지가 한 번에 추론된다.
+*/
+void encrypt_image_batch(
+    const seal::CKKSEncoder &encoder, const seal::Encryptor &encryptor, const std::vector<std::vector<double>> &images,
+    double scale, std::vector<seal::Ciphertext> &destination, const ParallelExecutor &executor = ParallelExecutor(1));
+
+/*
+Helper function: 배치 결과 암호문들을 복호화해 이미지별 출력 result[b][k]로 되돌린다.
+*/
+std::vector<std::vector<double>> decrypt_image_batch(
+    const seal::CKKSEncoder &encoder, seal::Decryptor &decryptor, const std::vector<seal::Ciphertext> &encrypted,
+    std::size_t batch_size);
+
+/*
+슬롯마다 다른 이미지를 담은 배치 암호문으로 SmallCnn을 추론한다 (CryptoNets).
+conv와 dense는 미리 인코딩한 스칼라 가중치의 multiply_plain 가중합이며 가중치는 현재 레벨의 마지막 소수를
+scale로 인코딩해 rescale 한 번에 scale을 유지한다. 평균 pooling은 덧셈만 하고 1 / window^2는 dense 가중치에
+합쳐 둔다. 레벨은 conv, x^2, dense에 하나씩 3개를 쓴다. 출력 뉴런마다 계산이 독립이므로 executor에 나눠 실행한다.
+*/
+class BatchedCnn
+{
+public:
+    BatchedCnn(
+        const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+        const seal::RelinKeys &relin_keys, const SmallCnn &model);
+
+    static constexpr std::size_t depth()
+    {
+        return 3;
+    }
+
+    const SmallCnn &model() const
+    {
+        return model_;
+    }
+
+    /*
+    pixels는 encrypt_image_batch의 결과. destination[k]의 슬롯 b에 이미지 b의 k번째 출력이 들어 있다.
+    */
+    void infer(
+        const std::vector<seal::Ciphertext> &pixels, std::vector<seal::Ciphertext> &destination,
+        const ParallelExecutor &executor = ParallelExecutor(1)) const;
+
+    /*
+    서비스 시작 시 모든 레벨의 가중치를 미리 인코딩한다.
+    */
+    void prepare() const;
+
+private:
+    const seal::SEALContext &context_;
+
+    const seal::Evaluator &evaluator_;
+
+    const seal::RelinKeys &relin_keys_;
+
+    SmallCnn model_;
+
+    // conv_weights_[((o * channels + c) * k + row) * k + col], dense_weights_[class * features + f]
+    WeightCache conv_weights_;
+
+    WeightCache conv_bias_;
+
+    WeightCache dense_weights_;
+
+    WeightCache dense_bias_;
+};
@@ -0,0 +1,366 @@
+#include "comparison.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+vector<double> sign_f_coefficients(size_t n)
+{
+    if (n == 0)
+    {
+        throw invalid_argument("n must be at least 1");
+    }
+
+    // x (1 - x^2)^i 를 전개해서 C(2i, i) / 4^i 배로 더한다
+    vector<double> coeffs(2 * n + 2, 0.0);
+    double weight = 1.0;
+    for (size_t i = 0; i <= n; i++)
+    {
+        if (i > 0)
+        {
+            weight *= static_cast<double>(2 * i - 1) / static_cast<double>(2 * i);
+        }
+        double binomial = 1.0;
+        for (size_t j = 0; j <= i; j++)
+        {
+            if (j > 0)
+            {
+                binomial *= static_cast<double>(i - j + 1) / static_cast<double>(j);
+            }
+            coeffs[2 * j + 1] += weight * binomial * ((j % 2) ? -1.0 : 1.0);
+        }
+    }
+    return coeffs;
+}
+
+vector<double> sign_g_coefficients(size_t n)
+{
+    // 2^-10 단위 (Cheon et al. 2020, 3.5절)
+    static const vector<vector<double>> table{
+        { 2126, -1359 },
+        { 3334, -6108, 3796 },
+        { 4589, -16577, 25614, -12860 },
+        { 5850, -34974, 97015, -113492, 46623 },
+    };
+    if (n == 0 || n > table.size())
+    {
+        throw invalid_argument("g_n is only tabulated for 1 <= n <= 4");
+    }
+
+    vector<double> coeffs(2 * n + 2, 0.0);
+    for (size_t j = 0; j <= n; j++)
+    {
+        coeffs[2 * j + 1] = table[n - 1][j] / 1024.0;
+    }
+    return coeffs;
+}
+
+SignConfig make_sign_config(size_t g_n, size_t g_iterations, size_t f_n, size_t f_iterations)
+{
+    if (g_n == 0 || g_n > 4 || f_n == 0 || f_n > 4)
+    {
+        throw invalid_argument("g_n and f_n must be between 1 and 4");
+    }
+    if (g_iterations + f_iterations == 0)
+    {
+        throw invalid_argument("at least one polynomial must be composed");
+    }
+    size_t g_depth = choose_paterson_stockmeyer(2 * g_n + 1, true).depth;
+    size_t f_depth = choose_paterson_stockmeyer(2 * f_n + 1, true).depth;
+    return { g_n, g_iterations, f_n, f_iterations, g_iterations * g_depth + f_iterations * f_depth };
+}
+
+namespace
+{
+    double evaluate_plain(const vector<double> &coeffs, double x)
+    {
+        double result = 0.0;
+        for (size_t i = coeffs.size(); i-- > 0;)
+        {
+            result = result * x + coeffs[i];
+        }
+        return result;
+    }
+
+    // [low, 1]의 로그 간격 점들
+    vector<double> log_spaced(double low)
+    {
+        const size_t points = 256;
+        vector<double> result(points);
+        for (size_t i = 0; i < points; i++)
+        {
+            result[i] = low * pow(1.0 / low, static_cast<double>(i) / static_cast<double>(points - 1));
+        }
+        return result;
+    }
+
+    /*
+    start의 모든 점 x에서 error(x, 합성 결과) <= tolerance인 설정 중 깊이가 가장 작은 것 (같으면 곱이 적은 것).
+    */
+    SignConfig search_sign_config(
+        const vector<double> &start, const function<double(double, double)> &error, double tolerance)
+    {
+        const size_t max_iterations = 20;
+        SignConfig best{ 0, 0, 0, 0, 0 };
+        size_t best_multiplications = 0;
+        for (size_t g_n = 1; g_n <= 4; g_n++)
+        {
+            vector<double> g = sign_g_coefficients(g_n);
+            size_t g_multiplications = choose_paterson_stockmeyer(2 * g_n + 1, true).nonscalar_multiplications;
+
+            vector<double> after_g = start;
+            for (size_t g_iterations = 0; g_iterations <= max_iterations; g_iterations++)
+            {
+                if (g_iterations > 0)
+                {
+                    for (double &v : after_g)
+                    {
+                        v = evaluate_plain(g, v);
+                    }
+                }
+                // g 단계 뒤의 f 차수는 따로 고른다 (g_n = 3 두 번 뒤 f_n = 4 한 번처럼 섞는 쪽이 얕을 수 있다)
+                for (size_t f_n = 1; f_n <= 4; f_n++)
+                {
+                    vector<double> f = sign_f_coefficients(f_n);
+                    size_t f_multiplications = choose_paterson_stockmeyer(2 * f_n + 1, true).nonscalar_multiplications;
+                    vector<double> values = after_g;
+                    for (size_t f_iterations = 0; g_iterations + f_iterations <= max_iterations; f_iterations++)
+                    {
+                        if (f_iterations > 0)
+                        {
+                            for (double &v : values)
+                            {
+                                v = evaluate_plain(f, v);
+                            }
+                        }
+                        double worst = 0.0;
+                        for (size_t i = 0; i < values.size(); i++)
+                        {
+                            worst = std::max(worst, error(start[i], values[i]));
+                        }
+                        if (worst > tolerance || g_iterations + f_iterations == 0)
+                        {
+                            continue;
+                        }
+
+                        SignConfig candidate = make_sign_config(g_n, g_iterations, f_n, f_iterations);
+                        size_t multiplications = g_iterations * g_multiplications + f_iterations * f_multiplications;
+                        if (best.depth == 0 || candidate.depth < best.depth ||
+                            (candidate.depth == best.depth && multiplications < best_multiplications))
+                        {
+                            best = candidate;
+                            best_multiplications = multiplications;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        if (best.depth == 0)
+        {
+            throw invalid_argument("no composite sign approximation reaches the precision target");
+        }
+        return best;
+    }
+} // namespace
+
+SignConfig choose_sign_config(double epsilon, int precision_bits)
+{
+    if (!(epsilon > 0.0 && epsilon < 1.0))
+    {
+        throw invalid_argument("epsilon must be in (0, 1)");
+    }
+    if (precision_bits < 1)
+    {
+        throw invalid_argument("precision_bits must be positive");
+    }
+    return search_sign_config(
+        log_spaced(epsilon), [](double, double v) { return fabs(1.0 - v); }, ldexp(1.0, -precision_bits));
+}
+
+SignConfig choose_max_config(int precision_bits)
+{
+    if (precision_bits < 1)
+    {
+        throw invalid_argument("precision_bits must be positive");
+    }
+
+    // x < 2 * tolerance이면 0 <= 합성 결과 <= 1이라 오차가 x / 2 이하이므로 그 위만 본다
+    double tolerance = ldexp(1.0, -precision_bits);
+    return search_sign_config(
+        log_spaced(min(2.0 * tolerance, 0.5)), [](double x, double v) { return x * fabs(1.0 - v) / 2.0; },
+        tolerance);
+}
+
+double sign_value_bound(const SignConfig &config)
+{
+    double bound = 1.0;
+    for (const auto &coeffs : { sign_f_coefficients(config.f_n), sign_g_coefficients(config.g_n) })
+    {
+        double sum = 0.0;
+        for (double c : coeffs)
+        {
+            sum += fabs(c);
+        }
+        bound = std::max(bound, sum);
+    }
+    return bound;
+}
+
+size_t max_circuit_depth(const SignConfig &config)
+{
+    return config.depth + (config.g_iterations + config.f_iterations > 1 ? 0 : 1);
+}
+
+size_t relu_depth(const SignConfig &config, double bound)
+{
+    // 1 / bound는 처음 합성하는 다항식의 계수에 합친다
+    size_t first_n = config.g_iterations > 0 ? config.g_n : config.f_n;
+    return max_circuit_depth(config) + (can_fold_input_scale(bound, 2 * first_n + 1) ? 0 : 1);
+}
+
+Comparator::Comparator(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys,
+    const SignConfig &config)
+    : polynomial_evaluator_(context, evaluator, encoder, relin_keys), aligned_(context, evaluator, encoder, relin_keys),
+      config_(make_sign_config(config.g_n, config.g_iterations, config.f_n, config.f_iterations)),
+      f_coeffs_(sign_f_coefficients(config.f_n)), g_coeffs_(sign_g_coefficients(config.g_n))
+{}
+
+void Comparator::composite_sign(
+    const Ciphertext &encrypted_x, double input_scale, double scale_last, double offset_last, double output_scale,
+    const Ciphertext *multiplier, Ciphertext &destination) const
+{
+    PatersonStockmeyerSplit g_split = choose_paterson_stockmeyer(2 * config_.g_n + 1, true);
+    PatersonStockmeyerSplit f_split = choose_paterson_stockmeyer(2 * config_.f_n + 1, true);
+    size_t total = config_.g_iterations + config_.f_iterations;
+    Ciphertext current = encrypted_x;
+    PatersonStockmeyerBasis basis;
+    for (size_t t = 0; t < total; t++)
+    {
+        vector<double> coeffs = (t < config_.g_iterations) ? g_coeffs_ : f_coeffs_;
+        if (t == 0 && input_scale != 1.0)
+        {
+            double power = 1.0;
+            for (double &c : coeffs)
+            {
+                c *= power;
+                power *= input_scale;
+            }
+        }
+        if (t + 1 == total)
+        {
+            for (double &c : coeffs)
+            {
+                c *= scale_last;
+            }
+            coeffs[0] += offset_last;
+        }
+        polynomial_evaluator_.compute_paterson_stockmeyer_basis(
+            current, (t < config_.g_iterations) ? g_split : f_split, basis);
+        if (t + 1 == total && output_scale > 0.0)
+        {
+            basis.scale = output_scale;
+        }
+        if (t + 1 == total && multiplier)
+        {
+            polynomial_evaluator_.evaluate_paterson_stockmeyer(basis, coeffs, *multiplier, current);
+        }
+        else
+        {
+            polynomial_evaluator_.evaluate_paterson_stockmeyer(basis, coeffs, current);
+        }
+    }
+    destination = move(current);
+}
+
+void Comparator::sign(const Ciphertext &encrypted_x, Ciphertext &destination) const
+{
+    composite_sign(encrypted_x, 1.0, 1.0, 0.0, 0.0, nullptr, destination);
+}
+
+void Comparator::compare(const Ciphertext &a, const Ciphertext &b, Ciphertext &destination) const
+{
+    Ciphertext difference;
+    aligned_.sub(a, b, difference);
+    composite_sign(difference, 1.0, 0.5, 0.5, 0.0, nullptr, destination);
+}
+
+void Comparator::half_abs(
+    const Ciphertext &encrypted_x, double input_scale, double factor, Ciphertext &destination) const
+{
+    const ScaleManager &scales = aligned_.scales();
+    size_t x_index = scales.chain_index(encrypted_x.parms_id());
+    if (x_index < max_depth())
+    {
+        throw invalid_argument("not enough levels to compute |x|");
+    }
+
+    double target_scale = encrypted_x.scale();
+    if (max_depth() == config_.depth)
+    {
+        // x * sign(x) / 2를 마지막 다항식에서 바로 만든다
+        composite_sign(encrypted_x, input_scale, 0.5 * factor, 0.0, 0.0, &encrypted_x, destination);
+        return;
+    }
+
+    // sign(x) / 2의 scale을 x와 곱하고 rescale했을 때 정확히 x의 scale이 되도록 정한다
+    double prime = scales.rescale_prime(scales.parms_id_at(x_index - config_.depth));
+    Ciphertext half_sign;
+    composite_sign(
+        encrypted_x, input_scale, 0.5 * factor, 0.0, target_scale * prime / encrypted_x.scale(), nullptr, half_sign);
+    aligned_.multiply(encrypted_x, half_sign, destination);
+    scales.settle_scale(destination, target_scale);
+}
+
+void Comparator::max(const Ciphertext &a, const Ciphertext &b, Ciphertext &destination) const
+{
+    Ciphertext difference;
+    aligned_.sub(a, b, difference);
+    Ciphertext product;
+    half_abs(difference, 1.0, 1.0, product);
+
+    // (a + b) / 2를 곱과 같은 레벨, 같은 scale로 만들어 더한다 (a + b는 레벨이 남으므로 깊이를 더 쓰지 않는다)
+    Ciphertext sum;
+    aligned_.add(a, b, sum);
+    Ciphertext half_sum;
+    aligned_.scales().multiply_const(sum, 0.5, product.parms_id(), product.scale(), half_sum);
+    aligned_.add(product, half_sum, destination);
+}
+
+void Comparator::relu(const Ciphertext &encrypted_x, double bound, Ciphertext &destination) const
+{
+    if (!(bound > 0.0))
+    {
+        throw invalid_argument("bound must be positive");
+    }
+    const ScaleManager &scales = aligned_.scales();
+
+    // relu(x) = bound * relu(x / bound). 1 / bound를 계수에 합치거나, 한 레벨을 써서 먼저 나눈다
+    const Ciphertext *input = &encrypted_x;
+    double input_scale = 1.0 / bound;
+    double factor = 1.0;
+    Ciphertext scaled;
+    if (relu_depth(config_, bound) > max_depth())
+    {
+        size_t x_index = scales.chain_index(encrypted_x.parms_id());
+        if (x_index < relu_depth(config_, bound))
+        {
+            throw invalid_argument("not enough levels to compute relu");
+        }
+        scales.multiply_const(
+            encrypted_x, 1.0 / bound, scales.parms_id_at(x_index - 1), encrypted_x.scale(), scaled);
+        input = &scaled;
+        input_scale = 1.0;
+        factor = bound;
+    }
+
+    Ciphertext product;
+    half_abs(*input, input_scale, factor, product);
+    Ciphertext half_x;
+    scales.multiply_const(*input, 0.5 * factor, product.parms_id(), product.scale(), half_x);
+    aligned_.add(product, half_x, destination);
+}
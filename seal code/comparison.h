@@ -0,0 +1,143 @@
+#pragma once
+
+#include "aligned_evaluator.h"
+#include "polynomial.h"
+#include "scale_manager.h"
+#include "seal/seal.h"
+#include <cstddef>
+#include <vector>
+
+/*
+합성 다항식으로 sign(x)를 근사하는 설정 (Cheon et al., "Efficient Homomorphic Comparison Methods with
+Optimal Complexity"). 차수 2g_n+1인 홀수 다항식 g_(g_n)을 g_iterations번, 차수 2f_n+1인 f_(f_n)을
+f_iterations번 차례로 합성한다. 두 단계의 차수는 따로 고른다.
+g_n은 0 근처의 작은 값을 빠르게 +-1 쪽으로 밀어내고 (Cheon et al. (2020)이 발표한 계수, 2^-10 단위),
+f_n은 +-1 근처에서 오차를 (1 - |x|)^(n+1)로 줄인다.
+depth는 전체 레벨 수. 차수 2n+1 다항식 한 번에 ceil(log2(2n + 2)) 레벨이다.
+*/
+struct SignConfig
+{
+    std::size_t g_n;
+    std::size_t g_iterations;
+    std::size_t f_n;
+    std::size_t f_iterations;
+    std::size_t depth;
+};
+
+/*
+Helper function: f_n(x) = sum_{i=0}^{n} C(2i, i) / 4^i * x (1 - x^2)^i 의 계수 (x^0부터). n >= 1.
+*/
+std::vector<double> sign_f_coefficients(std::size_t n);
+
+/*
+Helper function: g_n의 계수 (1 <= n <= 4). Cheon et al. (2020)의 2^-10 단위 정수 계수를 1024로 나눈 값.
+*/
+std::vector<double> sign_g_coefficients(std::size_t n);
+
+/*
+Helper function: 단계별 차수와 합성 횟수로 SignConfig를 만든다 (depth 계산). g_n, f_n은 1 ~ 4.
+*/
+SignConfig make_sign_config(std::size_t g_n, std::size_t g_iterations, std::size_t f_n, std::size_t f_iterations);
+
+/*
+Helper function: 입력이 [-1, -epsilon] U [epsilon, 1]일 때 |sign(x) - 결과| <= 2^-precision_bits가 되는
+설정 중 깊이가 가장 작은 것 (같으면 암호문 곱이 적은 것). g_n, f_n의 모든 조합을 평문에서 [epsilon, 1]의 점들에
+합성을 적용해 비교한다.
+epsilon을 키우거나 precision_bits를 줄이면 깊이가 줄어든다.
+*/
+SignConfig choose_sign_config(double epsilon, int precision_bits);
+
+/*
+Helper function: a, b가 [0, 1]일 때 Comparator::max의 오차 |a - b| * |1 - sign 근사| / 2가
+2^-precision_bits 이하가 되는 설정 중 깊이가 가장 작은 것.
+a - b가 0에 가까우면 곱해지는 |a - b|가 작아서 sign이 0 근처에서 부정확해도 되므로 choose_sign_config보다 훨씬 얕다.
+*/
+SignConfig choose_max_config(int precision_bits);
+
+/*
+Helper function: 합성 중 암호문이 가질 수 있는 값의 절댓값 상한 (CircuitSpec::value_bound).
+결과는 +-1 안이지만, Paterson-Stockmeyer 블록은 계수 절댓값의 합까지 커질 수 있다.
+*/
+double sign_value_bound(const SignConfig &config);
+
+/*
+Helper function: Comparator::max가 쓰는 레벨 수. 다항식을 두 번 이상 합성하면 (a - b)를 마지막 다항식에 합쳐서
+config.depth, 한 번뿐이면 마지막에 곱하므로 config.depth + 1.
+*/
+std::size_t max_circuit_depth(const SignConfig &config);
+
+/*
+Helper function: Comparator::relu가 쓰는 레벨 수. 1 / bound를 계수에 합칠 수 없으면 max_circuit_depth보다 1 크다.
+*/
+std::size_t relu_depth(const SignConfig &config, double bound);
+
+/*
+암호문 비교기. 모든 다항식은 깊이가 가장 작은 Paterson-Stockmeyer 분할로 평가하고,
+마지막 상수 배와 덧셈은 마지막 다항식의 계수에 합쳐서 레벨을 더 쓰지 않는다.
+*/
+class Comparator
+{
+public:
+    Comparator(
+        const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+        const seal::RelinKeys &relin_keys, const SignConfig &config);
+
+    const SignConfig &config() const
+    {
+        return config_;
+    }
+
+    /*
+    x는 [-1, 1]. config.depth 레벨을 쓰고 결과의 scale은 x의 scale과 같다.
+    */
+    void sign(const seal::Ciphertext &encrypted_x, seal::Ciphertext &destination) const;
+
+    /*
+    a, b는 [0, 1]. a > b이면 1, a < b이면 0 (같으면 1/2). config.depth 레벨.
+    */
+    void compare(const seal::Ciphertext &a, const seal::Ciphertext &b, seal::Ciphertext &destination) const;
+
+    /*
+    max(a, b) = (a + b) / 2 + (a - b) * sign(a - b) / 2. a, b는 [0, 1]. max_circuit_depth(config) 레벨.
+    결과의 scale은 a - b의 scale과 같다. a, b의 레벨이 달라도 된다.
+    */
+    void max(const seal::Ciphertext &a, const seal::Ciphertext &b, seal::Ciphertext &destination) const;
+
+    /*
+    relu(x) = x / 2 + x * sign(x / bound) / 2. x는 [-bound, bound]. relu_depth(config, bound) 레벨.
+    1 / bound는 can_fold_input_scale이면 첫 다항식의 계수에 합치고, 아니면 한 레벨을 써서 먼저 나눈다.
+    오차는 bound * (choose_max_config 기준 오차)까지.
+    */
+    void relu(const seal::Ciphertext &encrypted_x, double bound, seal::Ciphertext &destination) const;
+
+    std::size_t max_depth() const
+    {
+        return max_circuit_depth(config_);
+    }
+
+private:
+    /*
+    sign(input_scale * x) 합성. input_scale은 첫 다항식의 계수에 합친다. 마지막 다항식은 scale_last배 하고
+    offset_last를 더한 것으로 평가하고, 결과의 scale은 output_scale (0이면 x의 scale)로 정확히 맞춘다.
+    multiplier가 있으면 마지막 다항식에 곱해서 평가한다 (PolynomialEvaluator::evaluate_paterson_stockmeyer).
+    */
+    void composite_sign(
+        const seal::Ciphertext &encrypted_x, double input_scale, double scale_last, double offset_last,
+        double output_scale, const seal::Ciphertext *multiplier, seal::Ciphertext &destination) const;
+
+    /*
+    factor * x * sign(input_scale * x) / 2. max_circuit_depth(config) 레벨, 결과의 scale은 x의 scale과 같다.
+    */
+    void half_abs(
+        const seal::Ciphertext &encrypted_x, double input_scale, double factor, seal::Ciphertext &destination) const;
+
+    PolynomialEvaluator polynomial_evaluator_;
+
+    AlignedEvaluator aligned_;
+
+    SignConfig config_;
+
+    std::vector<double> f_coeffs_;
+
+    std::vector<double> g_coeffs_;
+};
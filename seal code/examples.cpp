@@ -36,6 +36,12 @@ int main()
         cout << "| 17. 17코드.                | 17_test.cpp                |" << endl;
         cout << "| 18. 18코드.                | 18_test.cpp                |" << endl;
         cout << "| 19. 19코드.                | 19_test.cpp                |" << endl;
+        cout << "| 20. 20코드.                | 20_test.cpp                |" << endl;
+        cout << "| 21. 21코드.                | 21_test.cpp                |" << endl;
+        cout << "| 22. 22코드.                | 22_test.cpp                |" << endl;
+        cout << "| 23. 23코드.                | 23_test.cpp                |" << endl;
+        cout << "| 24. 24코드.                | 24_test.cpp                |" << endl;
+        cout << "| 25. 25코드.                | 25_test.cpp                |" << endl;
         cout << "+----------------------------+----------------------------+" << endl;
 
         /*
@@ -52,7 +58,7 @@ int main()
         bool valid = true;
         do
         {
-            cout << endl << "> Run example (1 ~ 20) or exit (0): ";
+            cout << endl << "> Run example (1 ~ 25) or exit (0): ";
             if (!(cin >> selection))
             {
                 valid = false;
@@ -67,7 +73,7 @@ int main()
             }
             if (!valid)
             {
-                cout << "  [Beep~~] valid option: type 0 ~ 20" << endl;
+                cout << "  [Beep~~] valid option: type 0 ~ 25" << endl;
                 cin.clear();
                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
             }
@@ -146,6 +152,24 @@ int main()
         case 19:
             evaluate_polynomial_19();
             break;
+        case 20:
+            compare_20();
+            break;
+        case 21:
+            max_pool_21();
+            break;
+        case 22:
+            relu_22();
+            break;
+        case 23:
+            conv2d_23();
+            break;
+        case 24:
+            batched_inference_24();
+            break;
+        case 25:
+            low_latency_25();
+            break;
 
         case 0:
             return 0;
@@ -58,6 +58,18 @@ void evaluate_polynomial_18();
 
 void evaluate_polynomial_19();
 
+void compare_20();
+
+void max_pool_21();
+
+void relu_22();
+
+void conv2d_23();
+
+void batched_inference_24();
+
+void low_latency_25();
+
 
 
 /*
@@ -0,0 +1,1151 @@
+#include "linear_algebra.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace
+{
+    // n x n 정사각 행렬이고 복제된 벡터(2n)가 슬롯에 들어가는지 확인
+    void check_square_matrix(const vector<vector<double>> &matrix, size_t slot_count)
+    {
+        size_t n = matrix.size();
+        if (n == 0 || 2 * n > slot_count)
+        {
+            throw invalid_argument("matrix dimension does not fit into the slots");
+        }
+        for (const auto &row : matrix)
+        {
+            if (row.size() != n)
+            {
+                throw invalid_argument("matrix must be square");
+            }
+        }
+    }
+
+    // 다음 rescale에서 빠질 소수. 이 값을 평문 scale로 쓰면 rescale 후 scale이 그대로 유지된다.
+    double next_rescale_prime(const SEALContext &context, parms_id_type parms_id)
+    {
+        auto context_data = context.get_context_data(parms_id);
+        return static_cast<double>(context_data->parms().coeff_modulus().back().value());
+    }
+
+    // 회전 횟수 (n1 - 1) + (n2 - 1)이 최소인 BSGS 분할, 같은 비용이면 2의 거듭제곱 n1 우선
+    BsgsSplit split_dimension(size_t n)
+    {
+        BsgsSplit best{ n, 1 };
+        size_t best_cost = n - 1;
+        for (size_t baby = 1; baby <= n; baby++)
+        {
+            size_t giant = (n + baby - 1) / baby;
+            size_t cost = (baby - 1) + (giant - 1);
+            bool power_of_two = (baby & (baby - 1)) == 0;
+            bool best_power_of_two = (best.baby_steps & (best.baby_steps - 1)) == 0;
+            if (cost < best_cost || (cost == best_cost && power_of_two && !best_power_of_two))
+            {
+                best = { baby, giant };
+                best_cost = cost;
+            }
+        }
+        return best;
+    }
+
+    // baby step: 입력을 0 ~ n1-1 (x stride) 만큼 회전한 암호문을 한 번만 만들어 모든 giant step에서 재사용
+    vector<Ciphertext> make_baby_rotations(
+        const Evaluator &evaluator, const GaloisKeys &galois_keys, size_t baby_steps, size_t stride,
+        const Ciphertext &encrypted, MemoryPoolHandle pool)
+    {
+        vector<Ciphertext> baby_rotations(baby_steps);
+        baby_rotations[0] = encrypted;
+        for (size_t i = 1; i < baby_steps; i++)
+        {
+            evaluator.rotate_vector(encrypted, static_cast<int>(i * stride), galois_keys, baby_rotations[i], pool);
+        }
+        return baby_rotations;
+    }
+
+    // BSGS 합 (rescale 전). diagonal(k)는 giant step만큼 미리 회전된 k번째 대각선 평문을 돌려준다.
+    void sum_bsgs(
+        const Evaluator &evaluator, const GaloisKeys &galois_keys, BsgsSplit split, size_t n, size_t stride,
+        const vector<Ciphertext> &baby_rotations, const function<const Plaintext &(size_t)> &diagonal,
+        Ciphertext &destination, MemoryPoolHandle pool)
+    {
+        Ciphertext sum;
+        Ciphertext inner;
+        Ciphertext term;
+        for (size_t j = 0; j < split.giant_steps; j++)
+        {
+            size_t giant_offset = j * split.baby_steps;
+            evaluator.multiply_plain(baby_rotations[0], diagonal(giant_offset), inner, pool);
+            for (size_t i = 1; i < split.baby_steps && giant_offset + i < n; i++)
+            {
+                evaluator.multiply_plain(baby_rotations[i], diagonal(giant_offset + i), term, pool);
+                evaluator.add_inplace(inner, term);
+            }
+
+            // giant step: 안쪽 합 전체를 한 번만 회전
+            if (giant_offset != 0)
+            {
+                evaluator.rotate_vector_inplace(inner, static_cast<int>(giant_offset * stride), galois_keys, pool);
+            }
+            if (j == 0)
+            {
+                sum = move(inner);
+            }
+            else
+            {
+                evaluator.add_inplace(sum, inner);
+            }
+        }
+        destination = move(sum);
+    }
+
+    // 대각선 평문이 미리 인코딩된 BSGS 곱. 같은 scale의 곱을 모두 더한 뒤 한 번만 rescale한다.
+    void multiply_bsgs_core(
+        const Evaluator &evaluator, const GaloisKeys &galois_keys, BsgsSplit split, size_t stride,
+        const vector<Plaintext> &plain_diagonals, const Ciphertext &encrypted, Ciphertext &destination)
+    {
+        MemoryPoolHandle pool = MemoryManager::GetPool();
+        auto baby_rotations = make_baby_rotations(evaluator, galois_keys, split.baby_steps, stride, encrypted, pool);
+        Ciphertext sum;
+        sum_bsgs(
+            evaluator, galois_keys, split, plain_diagonals.size(), stride, baby_rotations,
+            [&](size_t k) -> const Plaintext & { return plain_diagonals[k]; }, sum, pool);
+        evaluator.rescale_to_next_inplace(sum, pool);
+        destination = move(sum);
+    }
+
+    // d가 2의 거듭제곱이고 d x d 행렬이 슬롯에 들어가는지 확인
+    void check_packed_dimension(size_t d, size_t slot_count)
+    {
+        if (d == 0 || (d & (d - 1)) != 0 || d * d > slot_count)
+        {
+            throw invalid_argument("packed matrix dimension must be a power of two with d * d <= slot_count");
+        }
+    }
+
+    // E2DM 치환: 출력 슬롯 l = d * i + j가 읽어 올 입력 슬롯
+    vector<size_t> sigma_source(size_t d)
+    {
+        vector<size_t> source(d * d);
+        for (size_t i = 0; i < d; i++)
+        {
+            for (size_t j = 0; j < d; j++)
+            {
+                source[d * i + j] = d * i + (i + j) % d;
+            }
+        }
+        return source;
+    }
+
+    vector<size_t> tau_source(size_t d)
+    {
+        vector<size_t> source(d * d);
+        for (size_t i = 0; i < d; i++)
+        {
+            for (size_t j = 0; j < d; j++)
+            {
+                source[d * i + j] = d * ((i + j) % d) + j;
+            }
+        }
+        return source;
+    }
+
+    vector<size_t> phi_source(size_t d, size_t k)
+    {
+        vector<size_t> source(d * d);
+        for (size_t i = 0; i < d; i++)
+        {
+            for (size_t j = 0; j < d; j++)
+            {
+                source[d * i + j] = d * i + (j + k) % d;
+            }
+        }
+        return source;
+    }
+
+    // 치환을 회전 step별 0/1 마스크로 분해. 마스크도 period 간격으로 슬롯 전체에 복제한다.
+    map<size_t, vector<double>> permutation_masks(const vector<size_t> &source, size_t slot_count)
+    {
+        size_t period = source.size();
+        map<size_t, vector<double>> masks;
+        for (size_t l = 0; l < period; l++)
+        {
+            size_t step = (source[l] + period - l) % period;
+            auto &mask = masks[step];
+            if (mask.empty())
+            {
+                mask.assign(slot_count, 0.0);
+            }
+            for (size_t c = l; c < slot_count; c += period)
+            {
+                mask[c] = 1.0;
+            }
+        }
+        return masks;
+    }
+
+    // 치환이 쓰는 회전 step (permutation_masks의 순서와 같다)
+    vector<size_t> permutation_steps(const vector<size_t> &source)
+    {
+        size_t period = source.size();
+        set<size_t> steps;
+        for (size_t l = 0; l < period; l++)
+        {
+            steps.insert((source[l] + period - l) % period);
+        }
+        return vector<size_t>(steps.begin(), steps.end());
+    }
+
+    // out = sum_step mask_step * rot(in, step), rescale 1번 (scale 유지). masks[offset + i]는 steps[i]의 마스크
+    void apply_permutation(
+        const Evaluator &evaluator, const GaloisKeys &galois_keys, const Ciphertext &encrypted,
+        const vector<size_t> &steps, const vector<Plaintext> &masks, size_t offset, Ciphertext &destination,
+        MemoryPoolHandle pool)
+    {
+        Ciphertext sum;
+        Ciphertext rotated;
+        Ciphertext term;
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            if (steps[i] == 0)
+            {
+                evaluator.multiply_plain(encrypted, masks[offset + i], term, pool);
+            }
+            else
+            {
+                evaluator.rotate_vector(encrypted, static_cast<int>(steps[i]), galois_keys, rotated, pool);
+                evaluator.multiply_plain(rotated, masks[offset + i], term, pool);
+            }
+
+            if (i == 0)
+            {
+                sum = move(term);
+            }
+            else
+            {
+                evaluator.add_inplace(sum, term);
+            }
+        }
+        evaluator.rescale_to_next_inplace(sum, pool);
+        destination = move(sum);
+    }
+} // namespace
+
+vector<double> replicate_vector(const vector<double> &vec, size_t copies, size_t slot_count)
+{
+    if (vec.size() * copies > slot_count)
+    {
+        throw invalid_argument("replicated vector does not fit into the slots");
+    }
+
+    vector<double> result(slot_count, 0.0);
+    for (size_t c = 0; c < copies; c++)
+    {
+        copy(vec.begin(), vec.end(), result.begin() + static_cast<ptrdiff_t>(c * vec.size()));
+    }
+    return result;
+}
+
+vector<vector<double>> generalized_diagonals(const vector<vector<double>> &matrix)
+{
+    size_t n = matrix.size();
+    vector<vector<double>> diagonals(n, vector<double>(n, 0.0));
+    for (size_t k = 0; k < n; k++)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            diagonals[k][j] = matrix[j][(j + k) % n];
+        }
+    }
+    return diagonals;
+}
+
+WeightCache make_diagonal_weights(const CKKSEncoder &encoder, const vector<vector<double>> &matrix)
+{
+    check_square_matrix(matrix, encoder.slot_count());
+    return WeightCache(encoder, generalized_diagonals(matrix));
+}
+
+void multiply_matrix_vector_diagonal(
+    const SEALContext &context, const Evaluator &evaluator, const GaloisKeys &galois_keys,
+    const WeightCache &diagonals, const Ciphertext &encrypted_vector, Ciphertext &destination)
+{
+    size_t n = diagonals.size();
+    const auto &plain_diagonals =
+        diagonals.get(encrypted_vector.parms_id(), next_rescale_prime(context, encrypted_vector.parms_id()));
+
+    // destination이 입력과 같은 객체일 수 있으므로 따로 누적
+    Ciphertext sum;
+    Ciphertext rotated;
+    Ciphertext term;
+    evaluator.multiply_plain(encrypted_vector, plain_diagonals[0], sum);
+    for (size_t k = 1; k < n; k++)
+    {
+        evaluator.rotate_vector(encrypted_vector, static_cast<int>(k), galois_keys, rotated);
+        evaluator.multiply_plain(rotated, plain_diagonals[k], term);
+        evaluator.add_inplace(sum, term);
+    }
+
+    // 같은 scale의 곱을 모두 더한 뒤 한 번만 rescale
+    evaluator.rescale_to_next_inplace(sum);
+    destination = move(sum);
+}
+
+void multiply_matrix_vector_diagonal(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const GaloisKeys &galois_keys,
+    const vector<vector<double>> &matrix, const Ciphertext &encrypted_vector, Ciphertext &destination)
+{
+    check_square_matrix(matrix, encoder.slot_count());
+    multiply_matrix_vector_sparse(
+        context, evaluator, encoder, galois_keys, to_diagonal_matrix(matrix), encrypted_vector, destination);
+}
+
+DiagonalMatrix to_diagonal_matrix(const vector<vector<double>> &matrix)
+{
+    size_t n = matrix.size();
+    for (const auto &row : matrix)
+    {
+        if (row.size() != n)
+        {
+            throw invalid_argument("matrix must be square");
+        }
+    }
+
+    DiagonalMatrix result{ n, {} };
+    for (size_t k = 0; k < n; k++)
+    {
+        vector<double> diagonal(n);
+        bool nonzero = false;
+        for (size_t j = 0; j < n; j++)
+        {
+            diagonal[j] = matrix[j][(j + k) % n];
+            nonzero = nonzero || diagonal[j] != 0.0;
+        }
+        if (nonzero)
+        {
+            result.diagonals.emplace(k, move(diagonal));
+        }
+    }
+    return result;
+}
+
+DiagonalMatrix make_diagonal_matrix(size_t n, const vector<SparseEntry> &entries)
+{
+    DiagonalMatrix result{ n, {} };
+    for (const auto &entry : entries)
+    {
+        if (entry.row >= n || entry.col >= n)
+        {
+            throw invalid_argument("sparse entry out of range");
+        }
+        if (entry.value == 0.0)
+        {
+            continue;
+        }
+        size_t k = (entry.col + n - entry.row) % n;
+        auto &diagonal = result.diagonals[k];
+        diagonal.resize(n, 0.0);
+        diagonal[entry.row] += entry.value;
+    }
+    return result;
+}
+
+DiagonalMatrix make_banded_matrix(size_t n, size_t lower, size_t upper, const MatrixEntry &entry)
+{
+    // 띠 안의 원소만 COO 목록으로 모아 대각선에 놓는다
+    // (위쪽 대각선은 offset 0 ~ upper, 아래쪽은 순환해서 offset n - lower ~ n - 1)
+    vector<SparseEntry> entries;
+    for (size_t j = 0; j < n; j++)
+    {
+        size_t first = j >= lower ? j - lower : 0;
+        size_t last = min(n - 1, j + upper);
+        for (size_t col = first; col <= last; col++)
+        {
+            entries.push_back({ j, col, entry(j, col) });
+        }
+    }
+    return make_diagonal_matrix(n, entries);
+}
+
+WeightCache make_sparse_diagonal_weights(const CKKSEncoder &encoder, const DiagonalMatrix &matrix)
+{
+    if (matrix.dimension == 0 || 2 * matrix.dimension > encoder.slot_count())
+    {
+        throw invalid_argument("matrix dimension does not fit into the slots");
+    }
+
+    vector<vector<double>> diagonals;
+    for (const auto &offset_diagonal : matrix.diagonals)
+    {
+        diagonals.push_back(offset_diagonal.second);
+    }
+    return WeightCache(encoder, move(diagonals));
+}
+
+void multiply_matrix_vector_sparse(
+    const SEALContext &context, const Evaluator &evaluator, const GaloisKeys &galois_keys,
+    const DiagonalMatrix &matrix, const WeightCache &diagonals, const Ciphertext &encrypted_vector,
+    Ciphertext &destination)
+{
+    if (matrix.diagonals.empty() || diagonals.size() != matrix.diagonals.size())
+    {
+        throw invalid_argument("sparse matrix has no nonzero diagonals or does not match its weights");
+    }
+    const auto &plain_diagonals =
+        diagonals.get(encrypted_vector.parms_id(), next_rescale_prime(context, encrypted_vector.parms_id()));
+
+    // 저장된 대각선만 회전 + multiply_plain
+    Ciphertext sum;
+    Ciphertext rotated;
+    Ciphertext term;
+    size_t index = 0;
+    for (const auto &offset_diagonal : matrix.diagonals)
+    {
+        size_t k = offset_diagonal.first;
+        if (k == 0)
+        {
+            evaluator.multiply_plain(encrypted_vector, plain_diagonals[index], term);
+        }
+        else
+        {
+            evaluator.rotate_vector(encrypted_vector, static_cast<int>(k), galois_keys, rotated);
+            evaluator.multiply_plain(rotated, plain_diagonals[index], term);
+        }
+
+        if (index == 0)
+        {
+            sum = move(term);
+        }
+        else
+        {
+            evaluator.add_inplace(sum, term);
+        }
+        index++;
+    }
+
+    evaluator.rescale_to_next_inplace(sum);
+    destination = move(sum);
+}
+
+void multiply_matrix_vector_sparse(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const GaloisKeys &galois_keys,
+    const DiagonalMatrix &matrix, const Ciphertext &encrypted_vector, Ciphertext &destination)
+{
+    multiply_matrix_vector_sparse(
+        context, evaluator, galois_keys, matrix, make_sparse_diagonal_weights(encoder, matrix), encrypted_vector,
+        destination);
+}
+
+BsgsSplit choose_bsgs_split(size_t n, size_t slot_count)
+{
+    if (n == 0 || 2 * n > slot_count)
+    {
+        throw invalid_argument("matrix dimension does not fit into the slots");
+    }
+    return split_dimension(n);
+}
+
+WeightCache make_bsgs_weights(const CKKSEncoder &encoder, const vector<vector<double>> &matrix)
+{
+    check_square_matrix(matrix, encoder.slot_count());
+    size_t n = matrix.size();
+    size_t slot_count = encoder.slot_count();
+    BsgsSplit split = choose_bsgs_split(n, slot_count);
+    auto diagonals = generalized_diagonals(matrix);
+
+    // giant step 회전을 상쇄하도록 k = j * n1 + i 번째 대각선을 평문에서 -j * n1 만큼 미리 회전
+    vector<vector<double>> shifted_diagonals(n, vector<double>(slot_count, 0.0));
+    for (size_t k = 0; k < n; k++)
+    {
+        size_t giant_offset = (k / split.baby_steps) * split.baby_steps;
+        for (size_t m = 0; m < n; m++)
+        {
+            shifted_diagonals[k][(m + giant_offset) % slot_count] = diagonals[k][m];
+        }
+    }
+    return WeightCache(encoder, move(shifted_diagonals));
+}
+
+void multiply_matrix_vector_bsgs(
+    const SEALContext &context, const Evaluator &evaluator, const GaloisKeys &galois_keys,
+    const WeightCache &shifted_diagonals, const Ciphertext &encrypted_vector, Ciphertext &destination)
+{
+    size_t n = shifted_diagonals.size();
+    BsgsSplit split = choose_bsgs_split(n, shifted_diagonals.values(0).size());
+    const auto &plain_diagonals =
+        shifted_diagonals.get(encrypted_vector.parms_id(), next_rescale_prime(context, encrypted_vector.parms_id()));
+    multiply_bsgs_core(evaluator, galois_keys, split, 1, plain_diagonals, encrypted_vector, destination);
+}
+
+void multiply_matrix_vector_bsgs(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const GaloisKeys &galois_keys,
+    const vector<vector<double>> &matrix, const Ciphertext &encrypted_vector, Ciphertext &destination)
+{
+    multiply_matrix_vector_bsgs(
+        context, evaluator, galois_keys, make_bsgs_weights(encoder, matrix), encrypted_vector, destination);
+}
+
+void rotate_and_sum(
+    const Evaluator &evaluator, const GaloisKeys &galois_keys, const Ciphertext &encrypted, size_t n,
+    Ciphertext &destination, MemoryPoolHandle pool)
+{
+    Ciphertext sum = encrypted;
+    Ciphertext rotated;
+    for (size_t step = 1; step < n; step <<= 1)
+    {
+        evaluator.rotate_vector(sum, static_cast<int>(step), galois_keys, rotated, pool);
+        evaluator.add_inplace(sum, rotated);
+    }
+    destination = move(sum);
+}
+
+RowPacking choose_row_packing(size_t n, size_t slot_count)
+{
+    size_t segment_size = 1;
+    while (segment_size < n)
+    {
+        segment_size <<= 1;
+    }
+    if (n == 0 || segment_size > slot_count)
+    {
+        throw invalid_argument("vector dimension does not fit into the slots");
+    }
+    return { segment_size, slot_count / segment_size };
+}
+
+WeightCache make_packed_rows_weights(const CKKSEncoder &encoder, const vector<vector<double>> &matrix)
+{
+    if (matrix.empty())
+    {
+        throw invalid_argument("matrix cannot be empty");
+    }
+    size_t n = matrix[0].size();
+    for (const auto &row : matrix)
+    {
+        if (row.size() != n)
+        {
+            throw invalid_argument("matrix rows must have the same length");
+        }
+    }
+
+    size_t slot_count = encoder.slot_count();
+    RowPacking packing = choose_row_packing(n, slot_count);
+    size_t ciphertext_count = (matrix.size() + packing.rows_per_ciphertext - 1) / packing.rows_per_ciphertext;
+
+    // 행 rows_per_ciphertext개를 segment 간격으로 한 평문에 배치
+    vector<vector<double>> packed_rows(ciphertext_count, vector<double>(slot_count, 0.0));
+    for (size_t row_index = 0; row_index < matrix.size(); row_index++)
+    {
+        size_t c = row_index / packing.rows_per_ciphertext;
+        size_t k = row_index % packing.rows_per_ciphertext;
+        copy(
+            matrix[row_index].begin(), matrix[row_index].end(),
+            packed_rows[c].begin() + static_cast<ptrdiff_t>(k * packing.segment_size));
+    }
+    return WeightCache(encoder, move(packed_rows));
+}
+
+void multiply_matrix_vector_packed_rows(
+    const SEALContext &context, const Evaluator &evaluator, const GaloisKeys &galois_keys, const RowPacking &packing,
+    const WeightCache &packed_rows, const Ciphertext &encrypted_vector, vector<Ciphertext> &destination,
+    const ParallelExecutor &executor)
+{
+    const auto &plain_rows =
+        packed_rows.get(encrypted_vector.parms_id(), next_rescale_prime(context, encrypted_vector.parms_id()));
+
+    vector<Ciphertext> results(plain_rows.size());
+    executor.run(plain_rows.size(), [&](size_t c, const MemoryPoolHandle &pool) {
+        Ciphertext product;
+        evaluator.multiply_plain(encrypted_vector, plain_rows[c], product, pool);
+
+        // 회전 전에 rescale해서 더 작은 모듈러스에서 key switch
+        evaluator.rescale_to_next_inplace(product, pool);
+        rotate_and_sum(evaluator, galois_keys, product, packing.segment_size, results[c], pool);
+    });
+    destination = move(results);
+}
+
+void multiply_matrix_vector_packed_rows(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const GaloisKeys &galois_keys,
+    const vector<vector<double>> &matrix, const Ciphertext &encrypted_vector, vector<Ciphertext> &destination)
+{
+    RowPacking packing = choose_row_packing(matrix.empty() ? 0 : matrix[0].size(), encoder.slot_count());
+    multiply_matrix_vector_packed_rows(
+        context, evaluator, galois_keys, packing, make_packed_rows_weights(encoder, matrix), encrypted_vector,
+        destination);
+}
+
+BatchLayout choose_batch_layout(size_t n, size_t slot_count)
+{
+    size_t dimension = 1;
+    while (dimension < n)
+    {
+        dimension <<= 1;
+    }
+    if (n == 0 || dimension > slot_count)
+    {
+        throw invalid_argument("vector dimension does not fit into the slots");
+    }
+    return { dimension, slot_count / dimension };
+}
+
+vector<double> interleave_vectors(const vector<vector<double>> &vectors, const BatchLayout &layout, size_t slot_count)
+{
+    if (vectors.size() > layout.batch_size)
+    {
+        throw invalid_argument("too many vectors for the batch layout");
+    }
+
+    vector<double> slots(slot_count, 0.0);
+    for (size_t b = 0; b < vectors.size(); b++)
+    {
+        if (vectors[b].size() > layout.dimension)
+        {
+            throw invalid_argument("vector is larger than the batch dimension");
+        }
+        for (size_t j = 0; j < vectors[b].size(); j++)
+        {
+            slots[j * layout.batch_size + b] = vectors[b][j];
+        }
+    }
+    return slots;
+}
+
+vector<vector<double>> deinterleave_vectors(
+    const vector<double> &slots, const BatchLayout &layout, size_t count, size_t n)
+{
+    vector<vector<double>> vectors(count, vector<double>(n));
+    for (size_t b = 0; b < count; b++)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            vectors[b][j] = slots[j * layout.batch_size + b];
+        }
+    }
+    return vectors;
+}
+
+WeightCache make_batched_weights(const CKKSEncoder &encoder, const vector<vector<double>> &matrix)
+{
+    size_t n = matrix.size();
+    for (const auto &row : matrix)
+    {
+        if (row.size() != n)
+        {
+            throw invalid_argument("matrix must be square");
+        }
+    }
+
+    size_t slot_count = encoder.slot_count();
+    BatchLayout layout = choose_batch_layout(n, slot_count);
+    size_t dimension = layout.dimension;
+    BsgsSplit split = split_dimension(dimension);
+
+    // dimension x dimension으로 0을 채운 행렬의 대각선
+    vector<vector<double>> padded(dimension, vector<double>(dimension, 0.0));
+    for (size_t i = 0; i < n; i++)
+    {
+        copy(matrix[i].begin(), matrix[i].end(), padded[i].begin());
+    }
+    auto diagonals = generalized_diagonals(padded);
+
+    // 길이 dimension의 순환 공간에서 giant step만큼 미리 회전한 뒤 모든 벡터 위치(b)에 펼친다
+    vector<vector<double>> batched_diagonals(dimension, vector<double>(slot_count, 0.0));
+    for (size_t k = 0; k < dimension; k++)
+    {
+        size_t giant_offset = (k / split.baby_steps) * split.baby_steps;
+        for (size_t m = 0; m < dimension; m++)
+        {
+            double value = diagonals[k][m];
+            size_t position = (m + giant_offset) % dimension;
+            for (size_t b = 0; b < layout.batch_size; b++)
+            {
+                batched_diagonals[k][position * layout.batch_size + b] = value;
+            }
+        }
+    }
+    return WeightCache(encoder, move(batched_diagonals));
+}
+
+void multiply_matrix_vector_batched(
+    const SEALContext &context, const Evaluator &evaluator, const GaloisKeys &galois_keys, const BatchLayout &layout,
+    const WeightCache &batched_diagonals, const Ciphertext &encrypted_vectors, Ciphertext &destination)
+{
+    const auto &plain_diagonals =
+        batched_diagonals.get(encrypted_vectors.parms_id(), next_rescale_prime(context, encrypted_vectors.parms_id()));
+    multiply_bsgs_core(
+        evaluator, galois_keys, split_dimension(layout.dimension), layout.batch_size, plain_diagonals,
+        encrypted_vectors, destination);
+}
+
+size_t choose_tile_size(size_t slot_count)
+{
+    return slot_count / 2;
+}
+
+void encrypt_tiled_vector(
+    const CKKSEncoder &encoder, const Encryptor &encryptor, const vector<double> &vec, double scale,
+    vector<Ciphertext> &destination)
+{
+    size_t slot_count = encoder.slot_count();
+    size_t tile_size = choose_tile_size(slot_count);
+    size_t tile_count = (vec.size() + tile_size - 1) / tile_size;
+
+    vector<Ciphertext> tiles(tile_count);
+    Plaintext plain_tile;
+    for (size_t c = 0; c < tile_count; c++)
+    {
+        auto first = vec.begin() + static_cast<ptrdiff_t>(c * tile_size);
+        vector<double> tile(first, first + static_cast<ptrdiff_t>(min(tile_size, vec.size() - c * tile_size)));
+        tile.resize(tile_size, 0.0);
+        encoder.encode(replicate_vector(tile, 2, slot_count), scale, plain_tile);
+        encryptor.encrypt(plain_tile, tiles[c]);
+    }
+    destination = move(tiles);
+}
+
+vector<double> decrypt_tiled_vector(
+    Decryptor &decryptor, const CKKSEncoder &encoder, const vector<Ciphertext> &encrypted_tiles, size_t n)
+{
+    size_t tile_size = choose_tile_size(encoder.slot_count());
+    vector<double> result(n);
+    Plaintext plain_tile;
+    vector<double> slots;
+    for (size_t r = 0; r < encrypted_tiles.size() && r * tile_size < n; r++)
+    {
+        decryptor.decrypt(encrypted_tiles[r], plain_tile);
+        encoder.decode(plain_tile, slots);
+        size_t count = min(tile_size, n - r * tile_size);
+        copy(slots.begin(), slots.begin() + static_cast<ptrdiff_t>(count),
+             result.begin() + static_cast<ptrdiff_t>(r * tile_size));
+    }
+    return result;
+}
+
+void multiply_matrix_vector_tiled(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder,
+    const GaloisKeys &galois_keys, size_t rows, size_t cols, const MatrixEntry &entry,
+    const vector<Ciphertext> &encrypted_tiles, vector<Ciphertext> &destination, const ParallelExecutor &executor)
+{
+    size_t slot_count = encoder.slot_count();
+    size_t tile_size = choose_tile_size(slot_count);
+    size_t row_tiles = (rows + tile_size - 1) / tile_size;
+    size_t col_tiles = (cols + tile_size - 1) / tile_size;
+    if (encrypted_tiles.size() != col_tiles)
+    {
+        throw invalid_argument("number of vector tiles does not match the matrix columns");
+    }
+    BsgsSplit split = split_dimension(tile_size);
+
+    // 입력 타일 c마다 baby step 회전을 만들고, 모든 출력 타일 r의 합에 (r, c) 블록의 곱을 더한다.
+    // 메모리에는 baby step 회전 n1개, 출력 합 row_tiles개, 작업마다 대각선 평문 1개만 둔다.
+    vector<Ciphertext> sums(row_tiles);
+    for (size_t c = 0; c < col_tiles; c++)
+    {
+        const Ciphertext &tile = encrypted_tiles[c];
+        double plain_scale = next_rescale_prime(context, tile.parms_id());
+        auto baby_rotations = make_baby_rotations(
+            evaluator, galois_keys, split.baby_steps, 1, tile, MemoryManager::GetPool());
+
+        executor.run(row_tiles, [&](size_t r, const MemoryPoolHandle &pool) {
+            // (r, c) 블록의 k번째 대각선을 giant step만큼 미리 회전해서 그때그때 인코딩
+            vector<double> values(slot_count);
+            Plaintext plain_diagonal;
+            auto diagonal = [&](size_t k) -> const Plaintext & {
+                size_t giant_offset = (k / split.baby_steps) * split.baby_steps;
+                fill(values.begin(), values.end(), 0.0);
+                for (size_t m = 0; m < tile_size; m++)
+                {
+                    size_t row = r * tile_size + m;
+                    size_t col = c * tile_size + (m + k) % tile_size;
+                    if (row < rows && col < cols)
+                    {
+                        values[(m + giant_offset) % slot_count] = entry(row, col);
+                    }
+                }
+                encoder.encode(values, tile.parms_id(), plain_scale, plain_diagonal, pool);
+                return plain_diagonal;
+            };
+
+            Ciphertext partial;
+            sum_bsgs(evaluator, galois_keys, split, tile_size, 1, baby_rotations, diagonal, partial, pool);
+            if (c == 0)
+            {
+                sums[r] = move(partial);
+            }
+            else
+            {
+                evaluator.add_inplace(sums[r], partial);
+            }
+        });
+    }
+
+    // 부분 곱을 모두 더한 뒤 출력 타일마다 rescale 한 번
+    executor.run(row_tiles, [&](size_t r, const MemoryPoolHandle &pool) {
+        evaluator.rescale_to_next_inplace(sums[r], pool);
+    });
+    destination = move(sums);
+}
+
+vector<double> pack_square_matrix(const vector<vector<double>> &matrix, size_t d, size_t slot_count)
+{
+    check_packed_dimension(d, slot_count);
+    if (matrix.size() > d)
+    {
+        throw invalid_argument("matrix is larger than the packed dimension");
+    }
+
+    vector<double> packed(d * d, 0.0);
+    for (size_t i = 0; i < matrix.size(); i++)
+    {
+        if (matrix[i].size() > d)
+        {
+            throw invalid_argument("matrix is larger than the packed dimension");
+        }
+        copy(matrix[i].begin(), matrix[i].end(), packed.begin() + static_cast<ptrdiff_t>(d * i));
+    }
+    return replicate_vector(packed, slot_count / (d * d), slot_count);
+}
+
+vector<vector<double>> unpack_square_matrix(const vector<double> &slots, size_t rows, size_t cols, size_t d)
+{
+    vector<vector<double>> matrix(rows, vector<double>(cols));
+    for (size_t i = 0; i < rows; i++)
+    {
+        for (size_t j = 0; j < cols; j++)
+        {
+            matrix[i][j] = slots[d * i + j];
+        }
+    }
+    return matrix;
+}
+
+PackedMatmulWeights make_packed_matmul_weights(const CKKSEncoder &encoder, size_t d)
+{
+    size_t slot_count = encoder.slot_count();
+    check_packed_dimension(d, slot_count);
+
+    // sigma, tau는 입력 레벨에서, phi^k는 그 다음 레벨에서 쓰므로 따로 인코딩한다
+    vector<vector<size_t>> steps;
+    vector<size_t> offsets;
+    vector<vector<double>> input_masks;
+    vector<vector<double>> shift_masks;
+    for (size_t p = 0; p < d + 1; p++)
+    {
+        vector<size_t> source = p == 0 ? sigma_source(d) : p == 1 ? tau_source(d) : phi_source(d, p - 1);
+        auto &masks = p < 2 ? input_masks : shift_masks;
+        offsets.push_back(masks.size());
+        steps.push_back(permutation_steps(source));
+        for (auto &step_mask : permutation_masks(source, slot_count))
+        {
+            masks.push_back(move(step_mask.second));
+        }
+    }
+    return PackedMatmulWeights{ d, move(steps), move(offsets), WeightCache(encoder, move(input_masks)),
+                                WeightCache(encoder, move(shift_masks)) };
+}
+
+void multiply_matrices_packed(
+    const SEALContext &context, const Evaluator &evaluator, const RelinKeys &relin_keys, const GaloisKeys &galois_keys,
+    const PackedMatmulWeights &weights, const Ciphertext &encrypted_a, const Ciphertext &encrypted_b,
+    Ciphertext &destination, MemoryPoolHandle pool)
+{
+    size_t d = weights.d;
+
+    // 1단계: sigma(A), tau(B) (레벨 1개)
+    Ciphertext sigma_a;
+    Ciphertext tau_b;
+    const auto &input_masks =
+        weights.input_masks.get(encrypted_a.parms_id(), next_rescale_prime(context, encrypted_a.parms_id()));
+    apply_permutation(evaluator, galois_keys, encrypted_a, weights.steps[0], input_masks, weights.offsets[0], sigma_a, pool);
+    apply_permutation(evaluator, galois_keys, encrypted_b, weights.steps[1], input_masks, weights.offsets[1], tau_b, pool);
+    const auto &shift_masks =
+        weights.shift_masks.get(sigma_a.parms_id(), next_rescale_prime(context, sigma_a.parms_id()));
+
+    // 2단계: phi^k(sigma(A))는 열 이동(회전 2번 + 마스크, 레벨 1개), psi^k(tau(B))는 행 이동(회전 1번)
+    // 3단계: 곱을 size 3 그대로 모두 더한 뒤 relinearize, rescale 한 번씩
+    Ciphertext sum;
+    Ciphertext shifted_a;
+    Ciphertext shifted_b;
+    Ciphertext product;
+    for (size_t k = 0; k < d; k++)
+    {
+        if (k == 0)
+        {
+            evaluator.mod_switch_to_next(sigma_a, shifted_a, pool);
+            shifted_b = tau_b;
+        }
+        else
+        {
+            apply_permutation(
+                evaluator, galois_keys, sigma_a, weights.steps[k + 1], shift_masks, weights.offsets[k + 1], shifted_a,
+                pool);
+            evaluator.rotate_vector(tau_b, static_cast<int>(d * k), galois_keys, shifted_b, pool);
+        }
+        evaluator.mod_switch_to_inplace(shifted_b, shifted_a.parms_id(), pool);
+
+        if (k == 0)
+        {
+            evaluator.multiply(shifted_a, shifted_b, sum, pool);
+        }
+        else
+        {
+            evaluator.multiply(shifted_a, shifted_b, product, pool);
+            evaluator.add_inplace(sum, product);
+        }
+    }
+    evaluator.relinearize_inplace(sum, relin_keys, pool);
+    evaluator.rescale_to_next_inplace(sum, pool);
+    destination = move(sum);
+}
+
+void multiply_matrices_packed(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys,
+    const GaloisKeys &galois_keys, size_t d, const Ciphertext &encrypted_a, const Ciphertext &encrypted_b,
+    Ciphertext &destination, MemoryPoolHandle pool)
+{
+    multiply_matrices_packed(
+        context, evaluator, relin_keys, galois_keys, make_packed_matmul_weights(encoder, d), encrypted_a, encrypted_b,
+        destination, pool);
+}
+
+size_t packed_matmul_key_count(size_t d)
+{
+    RotationKeyPlanner planner;
+    planner.add_packed_matmul(d);
+    return planner.steps().size();
+}
+
+size_t choose_block_dimension(size_t n, size_t m, size_t k, size_t slot_count, size_t max_galois_keys)
+{
+    size_t d = 1;
+    while (d < max({ n, m, k }))
+    {
+        d <<= 1;
+    }
+    while (d > 1 && (d * d > slot_count || packed_matmul_key_count(d) > max_galois_keys))
+    {
+        d >>= 1;
+    }
+    return d;
+}
+
+void encrypt_block_matrix(
+    const CKKSEncoder &encoder, const Encryptor &encryptor, const vector<vector<double>> &matrix,
+    size_t block_dimension, double scale, EncryptedBlockMatrix &destination)
+{
+    size_t rows = matrix.size();
+    size_t cols = rows ? matrix[0].size() : 0;
+    size_t b = block_dimension;
+    size_t block_rows = (rows + b - 1) / b;
+    size_t block_cols = (cols + b - 1) / b;
+
+    EncryptedBlockMatrix result{ rows, cols, b, vector<vector<Ciphertext>>(block_rows, vector<Ciphertext>(block_cols)) };
+    Plaintext plain_block;
+    for (size_t bi = 0; bi < block_rows; bi++)
+    {
+        for (size_t bj = 0; bj < block_cols; bj++)
+        {
+            // (bi, bj) 블록을 잘라내서 패킹
+            vector<vector<double>> block(min(b, rows - bi * b));
+            for (size_t i = 0; i < block.size(); i++)
+            {
+                const auto &row = matrix[bi * b + i];
+                auto first = row.begin() + static_cast<ptrdiff_t>(bj * b);
+                block[i].assign(first, first + static_cast<ptrdiff_t>(min(b, cols - bj * b)));
+            }
+            encoder.encode(pack_square_matrix(block, b, encoder.slot_count()), scale, plain_block);
+            encryptor.encrypt(plain_block, result.blocks[bi][bj]);
+        }
+    }
+    destination = move(result);
+}
+
+vector<vector<double>> decrypt_block_matrix(
+    Decryptor &decryptor, const CKKSEncoder &encoder, const EncryptedBlockMatrix &encrypted)
+{
+    size_t b = encrypted.block_dimension;
+    vector<vector<double>> matrix(encrypted.rows, vector<double>(encrypted.cols));
+    Plaintext plain_block;
+    vector<double> slots;
+    for (size_t bi = 0; bi < encrypted.blocks.size(); bi++)
+    {
+        for (size_t bj = 0; bj < encrypted.blocks[bi].size(); bj++)
+        {
+            decryptor.decrypt(encrypted.blocks[bi][bj], plain_block);
+            encoder.decode(plain_block, slots);
+            size_t block_rows = min(b, encrypted.rows - bi * b);
+            size_t block_cols = min(b, encrypted.cols - bj * b);
+            auto block = unpack_square_matrix(slots, block_rows, block_cols, b);
+            for (size_t i = 0; i < block_rows; i++)
+            {
+                copy(block[i].begin(), block[i].end(), matrix[bi * b + i].begin() + static_cast<ptrdiff_t>(bj * b));
+            }
+        }
+    }
+    return matrix;
+}
+
+void multiply_block_matrices(
+    const SEALContext &context, const Evaluator &evaluator, const RelinKeys &relin_keys, const GaloisKeys &galois_keys,
+    const PackedMatmulWeights &weights, const EncryptedBlockMatrix &a, const EncryptedBlockMatrix &b,
+    EncryptedBlockMatrix &destination, const ParallelExecutor &executor)
+{
+    if (a.cols != b.rows || a.block_dimension != b.block_dimension || a.block_dimension != weights.d)
+    {
+        throw invalid_argument("block matrix dimensions mismatch");
+    }
+
+    size_t d = a.block_dimension;
+    size_t block_rows = a.blocks.size();
+    size_t block_cols = b.blocks.empty() ? 0 : b.blocks[0].size();
+    size_t inner_blocks = b.blocks.size();
+
+    EncryptedBlockMatrix result{ a.rows, b.cols, d, vector<vector<Ciphertext>>(block_rows, vector<Ciphertext>(block_cols)) };
+    executor.run(block_rows * block_cols, [&](size_t index, const MemoryPoolHandle &pool) {
+        size_t i = index / block_cols;
+        size_t j = index % block_cols;
+        Ciphertext product;
+        for (size_t l = 0; l < inner_blocks; l++)
+        {
+            if (l == 0)
+            {
+                multiply_matrices_packed(
+                    context, evaluator, relin_keys, galois_keys, weights, a.blocks[i][l], b.blocks[l][j],
+                    result.blocks[i][j], pool);
+            }
+            else
+            {
+                multiply_matrices_packed(
+                    context, evaluator, relin_keys, galois_keys, weights, a.blocks[i][l], b.blocks[l][j], product,
+                    pool);
+                evaluator.add_inplace(result.blocks[i][j], product);
+            }
+        }
+    });
+    destination = move(result);
+}
+
+void multiply_block_matrices(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys,
+    const GaloisKeys &galois_keys, const EncryptedBlockMatrix &a, const EncryptedBlockMatrix &b,
+    EncryptedBlockMatrix &destination, const ParallelExecutor &executor)
+{
+    multiply_block_matrices(
+        context, evaluator, relin_keys, galois_keys, make_packed_matmul_weights(encoder, a.block_dimension), a, b,
+        destination, executor);
+}
+
+void RotationKeyPlanner::add_step(int step)
+{
+    if (step != 0)
+    {
+        steps_.insert(step);
+    }
+}
+
+void RotationKeyPlanner::add_rotate_and_sum(size_t n)
+{
+    for (size_t step = 1; step < n; step <<= 1)
+    {
+        add_step(static_cast<int>(step));
+    }
+}
+
+void RotationKeyPlanner::add_diagonal_matvec(size_t n)
+{
+    for (size_t k = 1; k < n; k++)
+    {
+        add_step(static_cast<int>(k));
+    }
+}
+
+void RotationKeyPlanner::add_sparse_matvec(const DiagonalMatrix &matrix)
+{
+    for (const auto &offset_diagonal : matrix.diagonals)
+    {
+        add_step(static_cast<int>(offset_diagonal.first));
+    }
+}
+
+void RotationKeyPlanner::add_bsgs_matvec(size_t n, size_t slot_count)
+{
+    BsgsSplit split = choose_bsgs_split(n, slot_count);
+    for (size_t i = 1; i < split.baby_steps; i++)
+    {
+        add_step(static_cast<int>(i));
+    }
+    for (size_t j = 1; j < split.giant_steps; j++)
+    {
+        add_step(static_cast<int>(j * split.baby_steps));
+    }
+}
+
+void RotationKeyPlanner::add_packed_rows_matvec(size_t n, size_t slot_count)
+{
+    add_rotate_and_sum(choose_row_packing(n, slot_count).segment_size);
+}
+
+void RotationKeyPlanner::add_tiled_matvec(size_t slot_count)
+{
+    BsgsSplit split = split_dimension(choose_tile_size(slot_count));
+    for (size_t i = 1; i < split.baby_steps; i++)
+    {
+        add_step(static_cast<int>(i));
+    }
+    for (size_t j = 1; j < split.giant_steps; j++)
+    {
+        add_step(static_cast<int>(j * split.baby_steps));
+    }
+}
+
+void RotationKeyPlanner::add_packed_matmul(size_t d)
+{
+    vector<vector<size_t>> sources = { sigma_source(d), tau_source(d) };
+    for (size_t k = 1; k < d; k++)
+    {
+        sources.push_back(phi_source(d, k));
+        add_step(static_cast<int>(d * k));
+    }
+    for (const auto &source : sources)
+    {
+        size_t period = source.size();
+        for (size_t l = 0; l < period; l++)
+        {
+            add_step(static_cast<int>((source[l] + period - l) % period));
+        }
+    }
+}
+
+void RotationKeyPlanner::add_batched_matvec(size_t n, size_t slot_count)
+{
+    BatchLayout layout = choose_batch_layout(n, slot_count);
+    BsgsSplit split = split_dimension(layout.dimension);
+    for (size_t i = 1; i < split.baby_steps; i++)
+    {
+        add_step(static_cast<int>(i * layout.batch_size));
+    }
+    for (size_t j = 1; j < split.giant_steps; j++)
+    {
+        add_step(static_cast<int>(j * split.baby_steps * layout.batch_size));
+    }
+}
+
+vector<int> RotationKeyPlanner::steps() const
+{
+    return vector<int>(steps_.begin(), steps_.end());
+}
+
+void RotationKeyPlanner::create_galois_keys(KeyGenerator &keygen, GaloisKeys &destination) const
+{
+    if (steps_.empty())
+    {
+        destination = GaloisKeys();
+        return;
+    }
+    keygen.create_galois_keys(steps(), destination);
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include "seal/seal.h"
+#include "parallel.h"
+#include "weight_cache.h"
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+/*
+암호화된 벡터와 평문 행렬의 선형대수 연산 모음.
+벡터는 슬롯 0번부터 채워져 있다고 가정한다.
+*/
+
+/*
+Helper function: vec을 copies번 이어 붙이고 나머지 슬롯은 0으로 채운 벡터를 만든다.
+대각선 방식 행렬-벡터 곱은 입력을 두 번 복제([v | v | 0 ...])해 두어야
+0 ~ n-1 회전이 앞쪽 n개 슬롯 안에서 순환한다.
+*/
+std::vector<double> replicate_vector(const std::vector<double> &vec, std::size_t copies, std::size_t slot_count);
+
+/*
+행렬 원소 (row, col)을 돌려주는 함수. 타일 곱, 띠 행렬 등은 행렬 전체를 메모리에 올리지 않고 이 함수로 읽는다.
+여러 스레드에서 동시에 호출될 수 있다.
+*/
+using MatrixEntry = std::function<double(std::size_t row, std::size_t col)>;
+
+/*
+Helper function: n x n 행렬의 일반화 대각선, diagonals[k][j] = matrix[j][(j + k) % n].
+*/
+std::vector<std::vector<double>> generalized_diagonals(const std::vector<std::vector<double>> &matrix);
+
+/*
+고정된 가중치 행렬은 make_*_weights로 한 번만 WeightCache를 만들고 WeightCache를 받는 커널을 쓴다.
+행렬을 직접 받는 커널은 호출할 때마다 평문을 새로 인코딩한다.
+*/
+
+/*
+Helper function: 대각선 방식 커널에 쓸 일반화 대각선 n개.
+*/
+WeightCache make_diagonal_weights(const seal::CKKSEncoder &encoder, const std::vector<std::vector<double>> &matrix);
+
+/*
+Halevi-Shoup 대각선 방식 행렬-벡터 곱: destination[j] = sum_k matrix[j][k] * v[k] (j < n).
+encrypted_vector는 replicate_vector(v, 2, slot_count)를 암호화한 것이어야 한다.
+회전 n-1번, multiply_plain n번, rescale 1번으로 결과 하나의 암호문을 돌려준다.
+대각선 평문은 현재 레벨의 마지막 소수를 scale로 인코딩하므로 rescale 후에도
+destination의 scale은 입력 scale과 같다.
+행렬을 직접 받는 쪽은 모두 0인 대각선을 찾아 multiply_matrix_vector_sparse로 건너뛴다.
+*/
+void multiply_matrix_vector_diagonal(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const WeightCache &diagonals, const seal::Ciphertext &encrypted_vector, seal::Ciphertext &destination);
+
+void multiply_matrix_vector_diagonal(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::GaloisKeys &galois_keys, const std::vector<std::vector<double>> &matrix,
+    const seal::Ciphertext &encrypted_vector, seal::Ciphertext &destination);
+
+/*
+희소/띠 행렬의 대각선 표현. diagonals[k]는 k번째 일반화 대각선(길이 dimension,
+diagonals[k][j] = matrix[j][(j + k) % dimension])이며 0이 아닌 원소가 있는 대각선만 저장한다.
+가지치기된 가중치처럼 0이 대부분인 행렬은 회전과 multiply_plain이 N이 아니라 저장된 대각선 수에 비례한다.
+*/
+struct DiagonalMatrix
+{
+    std::size_t dimension;
+    std::map<std::size_t, std::vector<double>> diagonals;
+};
+
+/*
+Helper function: 조밀한 n x n 행렬에서 모두 0인 대각선을 찾아 빼고 DiagonalMatrix로 바꾼다.
+*/
+DiagonalMatrix to_diagonal_matrix(const std::vector<std::vector<double>> &matrix);
+
+/*
+희소 행렬의 0이 아닌 원소 하나 (COO 형식).
+*/
+struct SparseEntry
+{
+    std::size_t row;
+    std::size_t col;
+    double value;
+};
+
+/*
+Helper function: 0이 아닌 원소 목록으로 n x n DiagonalMatrix를 만든다. 같은 위치의 원소는 더해진다.
+*/
+DiagonalMatrix make_diagonal_matrix(std::size_t n, const std::vector<SparseEntry> &entries);
+
+/*
+Helper function: 주대각선 아래로 lower개, 위로 upper개의 대각선만 있는 n x n 띠 행렬
+(row - lower <= col <= row + upper). 대각선은 최대 lower + upper + 1개.
+*/
+DiagonalMatrix make_banded_matrix(std::size_t n, std::size_t lower, std::size_t upper, const MatrixEntry &entry);
+
+/*
+Helper function: 저장된 대각선만 offset 순서대로 담은 평문용 벡터.
+*/
+WeightCache make_sparse_diagonal_weights(const seal::CKKSEncoder &encoder, const DiagonalMatrix &matrix);
+
+/*
+희소 대각선 방식 행렬-벡터 곱. multiply_matrix_vector_diagonal과 입력/출력 형식이 같지만
+저장된 대각선 offset에 대해서만 회전과 multiply_plain을 한다 (offset 0은 회전 없음).
+diagonals는 make_sparse_diagonal_weights(encoder, matrix)로 만든 것이어야 한다.
+*/
+void multiply_matrix_vector_sparse(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const DiagonalMatrix &matrix, const WeightCache &diagonals, const seal::Ciphertext &encrypted_vector,
+    seal::Ciphertext &destination);
+
+void multiply_matrix_vector_sparse(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::GaloisKeys &galois_keys, const DiagonalMatrix &matrix, const seal::Ciphertext &encrypted_vector,
+    seal::Ciphertext &destination);
+
+/*
+Baby-step/giant-step 분할. baby_steps * giant_steps >= n.
+*/
+struct BsgsSplit
+{
+    std::size_t baby_steps;
+    std::size_t giant_steps;
+};
+
+/*
+Helper function: 회전 횟수 (baby_steps - 1) + (giant_steps - 1)가 최소가 되는 분할을 고른다.
+같은 비용이면 기본 Galois 키 하나로 회전되는 2의 거듭제곱 baby step을 우선한다.
+*/
+BsgsSplit choose_bsgs_split(std::size_t n, std::size_t slot_count);
+
+/*
+Helper function: BSGS 커널에 쓸 대각선. giant step 회전을 상쇄하도록 평문에서 미리 회전해 둔다.
+*/
+WeightCache make_bsgs_weights(const seal::CKKSEncoder &encoder, const std::vector<std::vector<double>> &matrix);
+
+/*
+BSGS 방식 행렬-벡터 곱. 입력 형식과 결과는 multiply_matrix_vector_diagonal과 같다.
+baby step 회전(1 ~ n1-1)은 입력에서 한 번만 만들어 모든 giant step에서 재사용하고,
+대각선은 평문 상태에서 미리 -j*n1만큼 회전해 두므로 key switch는 약 2*sqrt(n)번이다.
+*/
+void multiply_matrix_vector_bsgs(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const WeightCache &shifted_diagonals, const seal::Ciphertext &encrypted_vector, seal::Ciphertext &destination);
+
+void multiply_matrix_vector_bsgs(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::GaloisKeys &galois_keys, const std::vector<std::vector<double>> &matrix,
+    const seal::Ciphertext &encrypted_vector, seal::Ciphertext &destination);
+
+/*
+슬롯 [0, n)의 합을 슬롯 0에 모은다. step = 1, 2, 4, ... 로 ceil(log2 n)번 회전+덧셈하므로
+슬롯 [n, 2^ceil(log2 n))은 0이어야 한다. 슬롯 k에는 [k, k + 2^ceil(log2 n))의 합이 남는다.
+*/
+void rotate_and_sum(
+    const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys, const seal::Ciphertext &encrypted,
+    std::size_t n, seal::Ciphertext &destination, seal::MemoryPoolHandle pool = seal::MemoryManager::GetPool());
+
+/*
+다중 행 패킹 레이아웃. 입력 벡터(길이 n)는 segment_size(= 2^ceil(log2 n)) 간격으로
+rows_per_ciphertext(= slot_count / segment_size)번 복제되고, 평문 하나에 같은 수의 행이 들어간다.
+*/
+struct RowPacking
+{
+    std::size_t segment_size;
+    std::size_t rows_per_ciphertext;
+};
+
+RowPacking choose_row_packing(std::size_t n, std::size_t slot_count);
+
+/*
+Helper function: 행 rows_per_ciphertext개씩 segment 간격으로 배치한 평문용 벡터.
+*/
+WeightCache make_packed_rows_weights(const seal::CKKSEncoder &encoder, const std::vector<std::vector<double>> &matrix);
+
+/*
+다중 행 패킹 방식 행렬-벡터 곱. matrix는 m x n (m은 임의)이며 encrypted_vector는
+segment_size 길이로 0을 채운 v를 replicate_vector(..., rows_per_ciphertext, slot_count)로 복제해 암호화한 것.
+평문 하나에 행 rows_per_ciphertext개를 나란히 놓으므로 multiply_plain 한 번과 구간별
+rotate_and_sum(log2 segment_size번 회전)으로 그만큼의 내적이 한꺼번에 계산된다.
+destination[c]의 슬롯 k * segment_size에 행 c * rows_per_ciphertext + k의 결과가 들어 있다.
+출력 암호문 c마다 계산이 독립이므로 executor의 스레드들에 나눠 실행한다.
+*/
+void multiply_matrix_vector_packed_rows(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const RowPacking &packing, const WeightCache &packed_rows, const seal::Ciphertext &encrypted_vector,
+    std::vector<seal::Ciphertext> &destination, const ParallelExecutor &executor = ParallelExecutor(1));
+
+void multiply_matrix_vector_packed_rows(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::GaloisKeys &galois_keys, const std::vector<std::vector<double>> &matrix,
+    const seal::Ciphertext &encrypted_vector, std::vector<seal::Ciphertext> &destination);
+
+/*
+여러 클라이언트 벡터를 한 암호문에 인터리빙하는 배치 레이아웃.
+dimension(= 2^ceil(log2 n)) x batch_size(= slot_count / dimension) = slot_count 이고,
+b번째 벡터의 j번째 원소는 슬롯 j * batch_size + b에 놓인다. 슬롯을 i * batch_size만큼 회전하면
+모든 벡터가 동시에 i만큼 순환하므로 별도의 복제 없이 대각선 방식을 그대로 쓸 수 있다.
+*/
+struct BatchLayout
+{
+    std::size_t dimension;
+    std::size_t batch_size;
+};
+
+BatchLayout choose_batch_layout(std::size_t n, std::size_t slot_count);
+
+/*
+Helper function: 클라이언트 측 인코딩. 최대 batch_size개의 벡터를 인터리빙한다.
+*/
+std::vector<double> interleave_vectors(
+    const std::vector<std::vector<double>> &vectors, const BatchLayout &layout, std::size_t slot_count);
+
+/*
+Helper function: 클라이언트 측 디코딩. 복호화된 슬롯에서 count개의 결과 벡터(길이 n)를 꺼낸다.
+*/
+std::vector<std::vector<double>> deinterleave_vectors(
+    const std::vector<double> &slots, const BatchLayout &layout, std::size_t count, std::size_t n);
+
+/*
+Helper function: 배치 커널용 대각선. 블록 대각 가중치를 인터리빙 레이아웃으로 펼치고
+BSGS giant step만큼 미리 회전해 둔다.
+*/
+WeightCache make_batched_weights(const seal::CKKSEncoder &encoder, const std::vector<std::vector<double>> &matrix);
+
+/*
+배치 행렬-벡터 곱. 같은 행렬을 batch_size개의 벡터에 한 번에 곱하며, 비용은 벡터 하나에 대한
+BSGS 곱과 같다(회전 약 2*sqrt(dimension)번). 결과도 같은 인터리빙 레이아웃이다.
+*/
+void multiply_matrix_vector_batched(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::GaloisKeys &galois_keys,
+    const BatchLayout &layout, const WeightCache &batched_diagonals, const seal::Ciphertext &encrypted_vectors,
+    seal::Ciphertext &destination);
+
+/*
+E2DM 방식 패킹 행렬 곱 (Jiang et al.).
+d x d 행렬(d는 2의 거듭제곱)을 행 우선으로 d^2 슬롯에 넣고 슬롯 전체에 slot_count / d^2번 복제한다.
+복제해 두면 슬롯 회전이 d^2 주기로 순환하므로 sigma/tau/phi/psi 치환을 회전과 마스크로 만들 수 있다.
+*/
+
+/*
+타일 행렬-벡터 곱에서 타일 하나의 길이. 타일을 두 번 복제해 슬롯에 넣으므로 slot_count / 2.
+*/
+std::size_t choose_tile_size(std::size_t slot_count);
+
+/*
+슬롯에 다 들어가지 않는 긴 벡터(길이 n > slot_count / 2)를 tile_size씩 잘라 타일마다 암호문 하나로 암호화한다.
+각 타일은 0을 채워 tile_size로 맞춘 뒤 replicate_vector(..., 2, slot_count)로 복제된다.
+*/
+void encrypt_tiled_vector(
+    const seal::CKKSEncoder &encoder, const seal::Encryptor &encryptor, const std::vector<double> &vec, double scale,
+    std::vector<seal::Ciphertext> &destination);
+
+/*
+Helper function: 타일 곱의 결과 암호문들을 복호화해서 길이 n의 벡터로 이어 붙인다.
+*/
+std::vector<double> decrypt_tiled_vector(
+    seal::Decryptor &decryptor, const seal::CKKSEncoder &encoder, const std::vector<seal::Ciphertext> &encrypted_tiles,
+    std::size_t n);
+
+/*
+타일 행렬-벡터 곱. rows x cols 행렬을 tile_size x tile_size 블록으로 나누고, 블록 (r, c)마다
+BSGS로 입력 타일 c를 곱해 출력 타일 r에 더한다. 부분 곱은 rescale하지 않고 모두 더한 뒤
+출력 타일마다 한 번만 rescale하므로 레벨 1개만 쓴다.
+대각선 평문은 블록을 읽으면서 하나씩 인코딩하고 바로 버리므로, 메모리에는 baby step 회전과
+출력 타일, 평문 1개(스레드마다)만 있다. 출력 타일 r의 계산은 executor의 스레드들에 나눠 실행한다.
+destination[r]의 슬롯 0 ~ tile_size-1에 행 r * tile_size ~ 의 결과가 들어 있다.
+*/
+void multiply_matrix_vector_tiled(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::GaloisKeys &galois_keys, std::size_t rows, std::size_t cols, const MatrixEntry &entry,
+    const std::vector<seal::Ciphertext> &encrypted_tiles, std::vector<seal::Ciphertext> &destination,
+    const ParallelExecutor &executor = ParallelExecutor(1));
+
+/*
+Helper function: 행렬(d 이하 크기)을 d x d로 0을 채워 패킹하고 슬롯 전체에 복제한다.
+*/
+std::vector<double> pack_square_matrix(
+    const std::vector<std::vector<double>> &matrix, std::size_t d, std::size_t slot_count);
+
+/*
+Helper function: 복호화된 슬롯에서 앞쪽 rows x cols 부분을 꺼낸다.
+*/
+std::vector<std::vector<double>> unpack_square_matrix(
+    const std::vector<double> &slots, std::size_t rows, std::size_t cols, std::size_t d);
+
+/*
+E2DM 치환 sigma, tau, phi^1 ~ phi^(d-1)을 회전 step별로 나눈 0/1 마스크. d마다 한 번 만들어 모든 블록 곱이 같이 쓴다.
+치환 p(0: sigma, 1: tau, k + 1: phi^k)의 회전 step은 steps[p], 마스크는 offsets[p]번부터 steps[p].size()개이며
+sigma, tau의 마스크는 input_masks에, phi^k의 마스크는 shift_masks에 있다 (쓰는 레벨이 달라 따로 인코딩한다).
+*/
+struct PackedMatmulWeights
+{
+    std::size_t d;
+    std::vector<std::vector<std::size_t>> steps;
+    std::vector<std::size_t> offsets;
+    WeightCache input_masks;
+    WeightCache shift_masks;
+};
+
+PackedMatmulWeights make_packed_matmul_weights(const seal::CKKSEncoder &encoder, std::size_t d);
+
+/*
+패킹된 d x d 암호문 행렬 두 개의 곱 A * B.
+AB = sum_k phi^k(sigma(A)) * psi^k(tau(B)) 로 계산하며 회전 약 6d번, 암호문 곱 d번,
+relinearize 1번, 레벨 3개를 쓴다. destination의 scale은 입력 scale^2 / q.
+마스크는 현재 레벨의 마지막 소수를 scale로 weights에서 꺼낸다.
+*/
+void multiply_matrices_packed(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::RelinKeys &relin_keys,
+    const seal::GaloisKeys &galois_keys, const PackedMatmulWeights &weights, const seal::Ciphertext &encrypted_a,
+    const seal::Ciphertext &encrypted_b, seal::Ciphertext &destination,
+    seal::MemoryPoolHandle pool = seal::MemoryManager::GetPool());
+
+void multiply_matrices_packed(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::RelinKeys &relin_keys, const seal::GaloisKeys &galois_keys, std::size_t d,
+    const seal::Ciphertext &encrypted_a, const seal::Ciphertext &encrypted_b, seal::Ciphertext &destination,
+    seal::MemoryPoolHandle pool = seal::MemoryManager::GetPool());
+
+/*
+블록 단위로 암호화된 행렬. blocks[i][j]는 (i, j)번째 d x d 블록을 pack_square_matrix로 패킹해 암호화한 것.
+직사각 행렬은 가장자리 블록을 0으로 채운다.
+*/
+struct EncryptedBlockMatrix
+{
+    std::size_t rows;
+    std::size_t cols;
+    std::size_t block_dimension;
+    std::vector<std::vector<seal::Ciphertext>> blocks;
+};
+
+/*
+Helper function: d x d 패킹 행렬 곱에 필요한 Galois 키 수 (약 3d).
+*/
+std::size_t packed_matmul_key_count(std::size_t d);
+
+/*
+Helper function: (N x M) * (M x K) 곱에 쓸 블록 크기. 세 차원 모두를 덮는 2의 거듭제곱이
+슬롯에 들어가면 블록 하나로, 아니면 d^2 <= slot_count인 가장 큰 2의 거듭제곱으로 나눈다.
+Galois 키는 하나가 N = 16384에서 수 MB이므로 packed_matmul_key_count(d) <= max_galois_keys로도 d를 제한한다
+(기본 96개면 d <= 32, 키 약 0.5GB). 블록이 작아지면 블록 곱 수는 (차원 / d)^3으로 늘어난다.
+*/
+std::size_t choose_block_dimension(
+    std::size_t n, std::size_t m, std::size_t k, std::size_t slot_count, std::size_t max_galois_keys = 96);
+
+void encrypt_block_matrix(
+    const seal::CKKSEncoder &encoder, const seal::Encryptor &encryptor, const std::vector<std::vector<double>> &matrix,
+    std::size_t block_dimension, double scale, EncryptedBlockMatrix &destination);
+
+std::vector<std::vector<double>> decrypt_block_matrix(
+    seal::Decryptor &decryptor, const seal::CKKSEncoder &encoder, const EncryptedBlockMatrix &encrypted);
+
+/*
+블록 행렬 곱 C_ij = sum_l A_il * B_lj. 블록 곱 결과는 같은 레벨/scale이라 그대로 더한다.
+출력 블록 (i, j)마다 executor의 작업 하나로 계산하며, l에 대한 합은 작업 안에서 순서대로 더하므로
+스레드 수와 관계없이 결과가 같다. 마스크는 make_packed_matmul_weights(encoder, block_dimension)를 한 번 만들어 넘긴다.
+*/
+void multiply_block_matrices(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::RelinKeys &relin_keys,
+    const seal::GaloisKeys &galois_keys, const PackedMatmulWeights &weights, const EncryptedBlockMatrix &a,
+    const EncryptedBlockMatrix &b, EncryptedBlockMatrix &destination,
+    const ParallelExecutor &executor = ParallelExecutor(1));
+
+void multiply_block_matrices(
+    const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+    const seal::RelinKeys &relin_keys, const seal::GaloisKeys &galois_keys, const EncryptedBlockMatrix &a,
+    const EncryptedBlockMatrix &b, EncryptedBlockMatrix &destination,
+    const ParallelExecutor &executor = ParallelExecutor(1));
+
+/*
+워크로드가 실제로 사용하는 회전 step만 모아서 Galois 키를 만든다.
+keygen.create_galois_keys(galois_keys)는 모든 2의 거듭제곱 step(양/음)을 만들기 때문에
+필요한 키만 만들면 키 생성 시간과 메모리가 줄어든다.
+*/
+class RotationKeyPlanner
+{
+public:
+    void add_step(int step);
+
+    void add_rotate_and_sum(std::size_t n);
+
+    void add_diagonal_matvec(std::size_t n);
+
+    void add_sparse_matvec(const DiagonalMatrix &matrix);
+
+    void add_bsgs_matvec(std::size_t n, std::size_t slot_count);
+
+    void add_packed_rows_matvec(std::size_t n, std::size_t slot_count);
+
+    void add_tiled_matvec(std::size_t slot_count);
+
+    void add_packed_matmul(std::size_t d);
+
+    void add_batched_matvec(std::size_t n, std::size_t slot_count);
+
+    std::vector<int> steps() const;
+
+    void create_galois_keys(seal::KeyGenerator &keygen, seal::GaloisKeys &destination) const;
+
+private:
+    std::set<int> steps_;
+};
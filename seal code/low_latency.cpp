@@ -0,0 +1,691 @@
+#include "low_latency.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std;
+using namespace seal;
+
+NetworkLayer make_conv_layer(const Conv2dShape &shape, ConvKernel kernel, vector<double> bias)
+{
+    if (bias.size() != shape.output_channels)
+    {
+        throw invalid_argument("conv bias must have output_channels entries");
+    }
+    NetworkLayer layer{ LayerKind::conv, shape, move(kernel), {}, move(bias) };
+    layer.matrix = conv2d_matrix(shape, layer.kernel);
+    return layer;
+}
+
+NetworkLayer make_square_layer()
+{
+    return { LayerKind::square, Conv2dShape{ FeatureMapShape{ 0, 0, 0 }, 0, 0, 1, 0 }, {}, {}, {} };
+}
+
+NetworkLayer make_dense_layer(vector<vector<double>> matrix, vector<double> bias)
+{
+    if (matrix.empty() || bias.size() != matrix.size())
+    {
+        throw invalid_argument("dense matrix and bias must have the same number of rows");
+    }
+    for (const auto &row : matrix)
+    {
+        if (row.size() != matrix[0].size())
+        {
+            throw invalid_argument("dense matrix rows must have the same length");
+        }
+    }
+    return { LayerKind::dense, Conv2dShape{ FeatureMapShape{ 0, 0, 0 }, 0, 0, 1, 0 }, {}, move(matrix), move(bias) };
+}
+
+namespace
+{
+    using Positions = vector<pair<size_t, size_t>>;
+
+    // 층의 출력 값 하나마다의 bias (conv는 출력 채널의 bias를 펼친다)
+    vector<double> expanded_bias(const NetworkLayer &layer)
+    {
+        if (layer.kind != LayerKind::conv)
+        {
+            return layer.bias;
+        }
+        size_t per_channel = layer.conv.output_height() * layer.conv.output_width();
+        vector<double> result;
+        for (double b : layer.bias)
+        {
+            result.insert(result.end(), per_channel, b);
+        }
+        return result;
+    }
+
+    size_t log2_ceil(size_t n)
+    {
+        size_t result = 0;
+        while ((size_t(1) << result) < n)
+        {
+            result++;
+        }
+        return result;
+    }
+
+    /*
+    층 사이의 값의 배치. packing은 interleaved 또는 stacked.
+    client이면 아직 어떤 층도 지나지 않은 입력이라 클라이언트가 다음 층의 표현으로 배치해 준다.
+    */
+    struct Layout
+    {
+        Packing packing;
+        Positions positions;
+        size_t ciphertexts;
+        bool client;
+    };
+
+    // 층 하나를 한 표현으로 계산하는 방법과 비용
+    struct LayerChoice
+    {
+        LayerPlan plan;
+        Layout output;
+
+        // stacked 입력을 마스크로 모은 암호문 수 (0이면 변환 없음)와 모은 뒤 행렬 열이 가리키는 슬롯
+        size_t merge_count;
+        Positions columns;
+
+        // dense: 복제 간격 (BSGS 차원 n'), stacked: 입력 복제 수와 행 패킹
+        size_t dimension;
+        size_t copies;
+        RowPacking row_packing;
+    };
+
+    bool describe_layer(
+        const NetworkLayer &layer, Packing packing, const Layout &input, size_t slot_count, LayerChoice &choice)
+    {
+        choice = LayerChoice{};
+        choice.plan = LayerPlan{ layer.kind, packing, 0, 0, 0, 0, input.ciphertexts };
+        if (layer.kind == LayerKind::square)
+        {
+            choice.plan.packing = input.packing;
+            choice.output = input;
+            choice.output.client = false;
+            choice.columns = input.positions;
+            return true;
+        }
+
+        size_t rows = layer.matrix.size();
+        if (layer.kind == LayerKind::conv && packing == Packing::convolution)
+        {
+            if (!input.client || !conv2d_fits(layer.conv, slot_count))
+            {
+                return false;
+            }
+            FeatureMapShape output_shape{ layer.conv.output_channels, layer.conv.output_height(),
+                                          layer.conv.output_width() };
+            Positions positions(output_shape.size());
+            for (size_t o = 0; o < output_shape.channels; o++)
+            {
+                for (size_t i = 0; i < output_shape.height; i++)
+                {
+                    for (size_t j = 0; j < output_shape.width; j++)
+                    {
+                        positions[output_shape.slot(o, i, j)] = { 0, layer.conv.output_slot(o, i, j) };
+                    }
+                }
+            }
+            choice.plan.rotations = conv2d_rotation_count(layer.conv);
+            choice.plan.total_rotations = choice.plan.rotations;
+            choice.plan.output_ciphertexts = 1;
+            choice.output = Layout{ Packing::interleaved, move(positions), 1, false };
+            return true;
+        }
+        if (packing != Packing::dense && packing != Packing::stacked)
+        {
+            return false;
+        }
+
+        // stacked 결과는 암호문 c의 값 슬롯만 마스크로 남기고 -c만큼 회전해 한 암호문에 모은다
+        choice.columns = input.positions;
+        if (input.packing == Packing::stacked)
+        {
+            size_t segment = slot_count;
+            for (const auto &position : input.positions)
+            {
+                if (position.second != 0)
+                {
+                    segment = min(segment, position.second);
+                }
+            }
+            if (input.ciphertexts > segment)
+            {
+                return false;
+            }
+            choice.merge_count = input.ciphertexts;
+            for (auto &position : choice.columns)
+            {
+                position = { 0, position.second + position.first };
+            }
+            choice.plan.conversion_levels = 1;
+            choice.plan.conversion_rotations = input.ciphertexts > 1 ? 1 : 0;
+            choice.plan.total_rotations = input.ciphertexts - 1;
+        }
+
+        size_t span = 0;
+        for (const auto &position : choice.columns)
+        {
+            span = max(span, position.second + 1);
+        }
+        if (packing == Packing::dense)
+        {
+            size_t dimension = max(span, rows);
+            if (2 * dimension > slot_count)
+            {
+                return false;
+            }
+            BsgsSplit split = choose_bsgs_split(dimension, slot_count);
+            size_t replicate = input.client ? 0 : 1;
+            choice.dimension = dimension;
+            choice.plan.conversion_rotations += replicate;
+            choice.plan.rotations = (split.baby_steps - 1) + (split.giant_steps - 1);
+            choice.plan.total_rotations += replicate + choice.plan.rotations;
+            choice.plan.output_ciphertexts = 1;
+            Positions positions(rows);
+            for (size_t i = 0; i < rows; i++)
+            {
+                positions[i] = { 0, i };
+            }
+            choice.output = Layout{ Packing::interleaved, move(positions), 1, false };
+            return true;
+        }
+
+        RowPacking row_packing = choose_row_packing(span, slot_count);
+        size_t per_ciphertext = row_packing.rows_per_ciphertext;
+        size_t copies = rows >= per_ciphertext ? per_ciphertext : (size_t(1) << log2_ceil(rows));
+        size_t replicate = input.client ? 0 : log2_ceil(copies);
+        size_t ciphertexts = (rows + per_ciphertext - 1) / per_ciphertext;
+        size_t sum_rotations = log2_ceil(row_packing.segment_size);
+        choice.row_packing = row_packing;
+        choice.copies = copies;
+        choice.plan.conversion_rotations += replicate;
+        choice.plan.rotations = sum_rotations;
+        choice.plan.total_rotations += replicate + ciphertexts * sum_rotations;
+        choice.plan.output_ciphertexts = ciphertexts;
+        Positions positions(rows);
+        for (size_t i = 0; i < rows; i++)
+        {
+            positions[i] = { i / per_ciphertext, (i % per_ciphertext) * row_packing.segment_size };
+        }
+        choice.output = Layout{ Packing::stacked, move(positions), ciphertexts, false };
+        return true;
+    }
+
+    Layout input_layout(const vector<NetworkLayer> &layers)
+    {
+        if (layers.empty())
+        {
+            throw invalid_argument("network has no layers");
+        }
+        size_t size = 0;
+        for (const auto &layer : layers)
+        {
+            if (layer.kind != LayerKind::square)
+            {
+                size = layer.matrix.empty() ? 0 : layer.matrix[0].size();
+                break;
+            }
+        }
+        if (size == 0)
+        {
+            throw invalid_argument("network needs a conv or dense layer");
+        }
+        Positions positions(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            positions[i] = { 0, i };
+        }
+        return Layout{ Packing::interleaved, move(positions), 1, true };
+    }
+
+    void check_dimensions(const vector<NetworkLayer> &layers)
+    {
+        size_t size = 0;
+        for (const auto &layer : layers)
+        {
+            if (layer.kind == LayerKind::square)
+            {
+                continue;
+            }
+            if (layer.matrix.empty() || expanded_bias(layer).size() != layer.matrix.size())
+            {
+                throw invalid_argument("layer weights and bias do not match");
+            }
+            if (size != 0 && layer.matrix[0].size() != size)
+            {
+                throw invalid_argument("layer input size does not match the previous layer");
+            }
+            size = layer.matrix.size();
+        }
+    }
+
+    vector<Packing> packing_options(const NetworkLayer &layer)
+    {
+        switch (layer.kind)
+        {
+        case LayerKind::conv:
+            return { Packing::convolution, Packing::dense, Packing::stacked };
+        case LayerKind::dense:
+            return { Packing::dense, Packing::stacked };
+        default:
+            return { Packing::interleaved };
+        }
+    }
+
+    NetworkPlan summarize(const vector<LayerPlan> &layers)
+    {
+        NetworkPlan plan{ layers, 0, 0, 0 };
+        for (const auto &layer : layers)
+        {
+            plan.critical_rotations += layer.conversion_rotations + layer.rotations;
+            plan.total_rotations += layer.total_rotations;
+            plan.depth += layer.conversion_levels + 1;
+        }
+        return plan;
+    }
+
+    bool better(const NetworkPlan &a, const NetworkPlan &b)
+    {
+        return make_tuple(a.critical_rotations, a.depth, a.total_rotations) <
+               make_tuple(b.critical_rotations, b.depth, b.total_rotations);
+    }
+
+    // 층 index부터 가능한 표현을 모두 시도한다
+    void search_plans(
+        const vector<NetworkLayer> &layers, size_t index, const Layout &input, size_t slot_count,
+        vector<LayerPlan> &current, NetworkPlan &best, bool &found)
+    {
+        if (index == layers.size())
+        {
+            NetworkPlan plan = summarize(current);
+            if (!found || better(plan, best))
+            {
+                best = plan;
+                found = true;
+            }
+            return;
+        }
+        for (Packing packing : packing_options(layers[index]))
+        {
+            LayerChoice choice;
+            if (!describe_layer(layers[index], packing, input, slot_count, choice))
+            {
+                continue;
+            }
+            current.push_back(choice.plan);
+            search_plans(layers, index + 1, choice.output, slot_count, current, best, found);
+            current.pop_back();
+        }
+    }
+
+    double next_rescale_prime(const SEALContext &context, parms_id_type parms_id)
+    {
+        auto context_data = context.get_context_data(parms_id);
+        return static_cast<double>(context_data->parms().coeff_modulus().back().value());
+    }
+} // namespace
+
+vector<double> evaluate_network(const vector<NetworkLayer> &layers, const vector<double> &input, double *max_abs)
+{
+    check_dimensions(layers);
+    vector<double> values = input;
+    double largest = 0.0;
+    for (double v : values)
+    {
+        largest = max(largest, fabs(v));
+    }
+    // stacked 결과의 segment 사이 부분합 상한. 다음 행렬 층의 마스크 전까지 square 층마다 함께 제곱된다
+    double partial = 0.0;
+    for (const auto &layer : layers)
+    {
+        if (layer.kind == LayerKind::square)
+        {
+            for (double &v : values)
+            {
+                v *= v;
+                largest = max(largest, v);
+            }
+            partial *= partial;
+            largest = max(largest, partial);
+            continue;
+        }
+        if (values.size() != layer.matrix[0].size())
+        {
+            throw invalid_argument("input does not match the first layer");
+        }
+        vector<double> bias = expanded_bias(layer);
+        vector<double> next(layer.matrix.size());
+        double first = 0.0;
+        double second = 0.0;
+        for (size_t i = 0; i < next.size(); i++)
+        {
+            next[i] = bias[i];
+            double row = 0.0;
+            for (size_t j = 0; j < values.size(); j++)
+            {
+                double term = layer.matrix[i][j] * values[j];
+                next[i] += term;
+                row += fabs(term);
+            }
+            largest = max(largest, max(row, fabs(next[i])));
+            if (row > first)
+            {
+                second = first;
+                first = row;
+            }
+            else if (row > second)
+            {
+                second = row;
+            }
+        }
+        partial = first + second;
+        largest = max(largest, partial);
+        values = move(next);
+    }
+    if (max_abs)
+    {
+        *max_abs = largest;
+    }
+    return values;
+}
+
+NetworkPlan plan_network(const vector<NetworkLayer> &layers, size_t slot_count)
+{
+    check_dimensions(layers);
+    vector<LayerPlan> current;
+    NetworkPlan best{};
+    bool found = false;
+    search_plans(layers, 0, input_layout(layers), slot_count, current, best, found);
+    if (!found)
+    {
+        throw invalid_argument("network does not fit into the slots");
+    }
+    return best;
+}
+
+NetworkPlan plan_network(const vector<NetworkLayer> &layers, const vector<Packing> &packings, size_t slot_count)
+{
+    check_dimensions(layers);
+    if (packings.size() != layers.size())
+    {
+        throw invalid_argument("packings must have one entry per layer");
+    }
+    Layout layout = input_layout(layers);
+    vector<LayerPlan> plans;
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        LayerChoice choice;
+        if (!describe_layer(layers[i], packings[i], layout, slot_count, choice))
+        {
+            throw invalid_argument("packing cannot be used for this layer");
+        }
+        plans.push_back(choice.plan);
+        layout = move(choice.output);
+    }
+    return summarize(plans);
+}
+
+LowLatencyNetwork::LowLatencyNetwork(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys,
+    const vector<NetworkLayer> &layers, const NetworkPlan &plan)
+    : context_(context), evaluator_(evaluator), encoder_(encoder), relin_keys_(relin_keys), plan_(plan)
+{
+    check_dimensions(layers);
+    if (plan_.layers.size() != layers.size())
+    {
+        throw invalid_argument("plan does not match the layers");
+    }
+
+    size_t slot_count = encoder.slot_count();
+    Layout layout = input_layout(layers);
+    input_size_ = layout.positions.size();
+    for (size_t index = 0; index < layers.size(); index++)
+    {
+        const NetworkLayer &layer = layers[index];
+        LayerChoice choice;
+        if (!describe_layer(layer, plan_.layers[index].packing, layout, slot_count, choice))
+        {
+            throw invalid_argument("plan cannot be used for these layers");
+        }
+
+        Step step{ layer.kind, choice.plan.packing, layer.conv, choice.merge_count, choice.dimension, choice.copies,
+                   choice.row_packing, nullptr, nullptr, nullptr };
+        if (layer.kind != LayerKind::square)
+        {
+            // stacked 결과를 모으는 마스크: 암호문 c에서 값이 있는 슬롯만 1
+            if (choice.merge_count > 0)
+            {
+                vector<vector<double>> masks(choice.merge_count, vector<double>(slot_count, 0.0));
+                for (const auto &position : layout.positions)
+                {
+                    masks[position.first][position.second] = 1.0;
+                }
+                step.masks.reset(new WeightCache(encoder, move(masks)));
+            }
+
+            // 행렬의 열 j를 값 j가 놓인 슬롯으로 옮겨 입력 배치를 가중치에 합친다
+            if (step.packing == Packing::convolution)
+            {
+                step.weights.reset(new WeightCache(make_conv2d_weights(encoder, layer.conv, layer.kernel)));
+            }
+            else
+            {
+                size_t width = step.packing == Packing::dense ? step.dimension : step.row_packing.segment_size;
+                size_t height = step.packing == Packing::dense ? step.dimension : layer.matrix.size();
+                vector<vector<double>> folded(height, vector<double>(width, 0.0));
+                for (size_t i = 0; i < layer.matrix.size(); i++)
+                {
+                    for (size_t j = 0; j < choice.columns.size(); j++)
+                    {
+                        folded[i][choice.columns[j].second] = layer.matrix[i][j];
+                    }
+                }
+                if (step.packing == Packing::dense)
+                {
+                    step.weights.reset(new WeightCache(make_bsgs_weights(encoder, folded)));
+                }
+                else
+                {
+                    step.weights.reset(new WeightCache(make_packed_rows_weights(encoder, folded)));
+                }
+            }
+
+            vector<double> bias = expanded_bias(layer);
+            vector<vector<double>> bias_slots(choice.output.ciphertexts, vector<double>(slot_count, 0.0));
+            for (size_t i = 0; i < bias.size(); i++)
+            {
+                const auto &position = choice.output.positions[i];
+                bias_slots[position.first][position.second] = bias[i];
+            }
+            step.bias.reset(new WeightCache(encoder, move(bias_slots)));
+        }
+        steps_.push_back(move(step));
+        layout = move(choice.output);
+    }
+    output_positions_ = move(layout.positions);
+}
+
+vector<int> LowLatencyNetwork::galois_steps() const
+{
+    RotationKeyPlanner planner;
+    size_t slot_count = encoder_.slot_count();
+    for (size_t index = 0; index < steps_.size(); index++)
+    {
+        const Step &step = steps_[index];
+        if (step.kind == LayerKind::square)
+        {
+            continue;
+        }
+        for (size_t c = 1; c < step.merge_count; c++)
+        {
+            planner.add_step(-static_cast<int>(c));
+        }
+        bool replicate = index > 0;
+        switch (step.packing)
+        {
+        case Packing::convolution:
+            for (int s : conv2d_steps(step.conv))
+            {
+                planner.add_step(s);
+            }
+            break;
+        case Packing::dense:
+            if (replicate)
+            {
+                planner.add_step(-static_cast<int>(step.dimension));
+            }
+            planner.add_bsgs_matvec(step.dimension, slot_count);
+            break;
+        default:
+            for (size_t copies = 1; replicate && copies < step.copies; copies <<= 1)
+            {
+                planner.add_step(-static_cast<int>(copies * step.row_packing.segment_size));
+            }
+            planner.add_rotate_and_sum(step.row_packing.segment_size);
+            break;
+        }
+    }
+    return planner.steps();
+}
+
+vector<double> LowLatencyNetwork::encode_input(const vector<double> &input) const
+{
+    if (input.size() != input_size_)
+    {
+        throw invalid_argument("input does not match the first layer");
+    }
+    size_t slot_count = encoder_.slot_count();
+
+    // 첫 행렬 층의 표현으로 배치한다 (앞에 square만 있으면 그 층이 복제를 맡는다)
+    const Step &first = steps_.front();
+    switch (first.packing)
+    {
+    case Packing::convolution:
+        return replicate_channels(first.conv, input, slot_count);
+    case Packing::dense:
+    {
+        vector<double> padded(input);
+        padded.resize(first.dimension, 0.0);
+        return replicate_vector(padded, 2, slot_count);
+    }
+    case Packing::stacked:
+    {
+        vector<double> padded(input);
+        padded.resize(first.row_packing.segment_size, 0.0);
+        return replicate_vector(padded, first.copies, slot_count);
+    }
+    default:
+    {
+        vector<double> padded(input);
+        padded.resize(slot_count, 0.0);
+        return padded;
+    }
+    }
+}
+
+void LowLatencyNetwork::infer(
+    const GaloisKeys &galois_keys, const Ciphertext &encrypted, vector<Ciphertext> &destination,
+    const ParallelExecutor &executor) const
+{
+    if (context_.get_context_data(encrypted.parms_id())->chain_index() < plan_.depth)
+    {
+        throw invalid_argument("not enough levels for the network");
+    }
+
+    vector<Ciphertext> current{ encrypted };
+    for (size_t index = 0; index < steps_.size(); index++)
+    {
+        const Step &step = steps_[index];
+        if (step.kind == LayerKind::square)
+        {
+            executor.run(current.size(), [&](size_t c, const MemoryPoolHandle &pool) {
+                evaluator_.square_inplace(current[c], pool);
+                evaluator_.relinearize_inplace(current[c], relin_keys_, pool);
+                evaluator_.rescale_to_next_inplace(current[c], pool);
+            });
+            continue;
+        }
+
+        // stacked -> interleaved: 값 슬롯만 남기고 암호문 c를 -c만큼 회전해 더한다
+        if (step.masks)
+        {
+            parms_id_type parms_id = current[0].parms_id();
+            const auto &masks = step.masks->get(parms_id, next_rescale_prime(context_, parms_id));
+            executor.run(current.size(), [&](size_t c, const MemoryPoolHandle &pool) {
+                evaluator_.multiply_plain_inplace(current[c], masks[c], pool);
+                evaluator_.rescale_to_next_inplace(current[c], pool);
+                if (c > 0)
+                {
+                    evaluator_.rotate_vector_inplace(current[c], -static_cast<int>(c), galois_keys, pool);
+                }
+            });
+            for (size_t c = 1; c < current.size(); c++)
+            {
+                evaluator_.add_inplace(current[0], current[c]);
+            }
+            current.resize(1);
+        }
+
+        Ciphertext input = move(current[0]);
+        Ciphertext rotated;
+        bool replicate = index > 0;
+        vector<Ciphertext> output(1);
+        switch (step.packing)
+        {
+        case Packing::convolution:
+            conv2d(context_, evaluator_, galois_keys, step.conv, *step.weights, input, output[0]);
+            break;
+        case Packing::dense:
+            if (replicate)
+            {
+                evaluator_.rotate_vector(input, -static_cast<int>(step.dimension), galois_keys, rotated);
+                evaluator_.add_inplace(input, rotated);
+            }
+            multiply_matrix_vector_bsgs(context_, evaluator_, galois_keys, *step.weights, input, output[0]);
+            break;
+        default:
+            for (size_t copies = 1; replicate && copies < step.copies; copies <<= 1)
+            {
+                evaluator_.rotate_vector(
+                    input, -static_cast<int>(copies * step.row_packing.segment_size), galois_keys, rotated);
+                evaluator_.add_inplace(input, rotated);
+            }
+            multiply_matrix_vector_packed_rows(
+                context_, evaluator_, galois_keys, step.row_packing, *step.weights, input, output, executor);
+            break;
+        }
+
+        const auto &bias = step.bias->get(output[0].parms_id(), output[0].scale());
+        for (size_t c = 0; c < output.size(); c++)
+        {
+            evaluator_.add_plain_inplace(output[c], bias[c]);
+        }
+        current = move(output);
+    }
+    destination = move(current);
+}
+
+vector<double> LowLatencyNetwork::decrypt_output(
+    const CKKSEncoder &encoder, Decryptor &decryptor, const vector<Ciphertext> &encrypted) const
+{
+    vector<vector<double>> decoded(encrypted.size());
+    Plaintext plain;
+    for (size_t c = 0; c < encrypted.size(); c++)
+    {
+        decryptor.decrypt(encrypted[c], plain);
+        encoder.decode(plain, decoded[c]);
+    }
+
+    vector<double> result(output_positions_.size());
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        result[i] = decoded.at(output_positions_[i].first).at(output_positions_[i].second);
+    }
+    return result;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "cnn.h"
+#include "linear_algebra.h"
+#include "parallel.h"
+#include "weight_cache.h"
+#include "seal/seal.h"
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*
+LoLa 방식 저지연 추론 (Brutzkus et al.). 이미지 하나를 암호문 하나에 넣고, 층마다 벡터 표현을 골라
+층 사이에 회전/마스크 변환을 넣어 임계 경로의 회전 수를 줄인다.
+CryptoNets 방식 배치 추론(BatchedCnn)이 처리량을 위한 것이라면 이쪽은 질의 하나의 지연 시간을 위한 것이다.
+*/
+
+enum class LayerKind
+{
+    conv,
+    square,
+    dense
+};
+
+/*
+평문 층. conv는 conv, kernel과 출력 채널마다의 bias를, dense는 m x n matrix와 bias(m개)를 쓴다. square는 x^2.
+층 사이의 값은 FeatureMapShape 순서로 펼친 벡터로 본다 (conv 출력은 (output_channels, output_height, output_width)).
+*/
+struct NetworkLayer
+{
+    LayerKind kind;
+    Conv2dShape conv;
+    ConvKernel kernel;
+    std::vector<std::vector<double>> matrix;
+    std::vector<double> bias;
+};
+
+NetworkLayer make_conv_layer(const Conv2dShape &shape, ConvKernel kernel, std::vector<double> bias);
+
+NetworkLayer make_square_layer();
+
+NetworkLayer make_dense_layer(std::vector<std::vector<double>> matrix, std::vector<double> bias);
+
+/*
+Helper function: 평문 추론. 결과는 마지막 층의 출력.
+max_abs가 있으면 암호문에 나타날 수 있는 값의 최대 절댓값을 넣는다: 각 층의 값, 행렬 층의 회전 합 도중
+부분합(행마다 |w_ij x_j|의 합), stacked 결과의 segment 사이 슬롯에 남는 부분합(이웃한 두 행에 걸치므로 가장 큰
+두 행의 합)과 그 부분합이 마스크로 지워지기 전에 square 층에서 제곱된 값. 고른 표현과 무관한 상한이다.
+*/
+std::vector<double> evaluate_network(
+    const std::vector<NetworkLayer> &layers, const std::vector<double> &input, double *max_abs = nullptr);
+
+/*
+벡터 표현.
+convolution: replicate_channels 형식. conv2d 커널의 입력이며 네트워크의 첫 층일 때만 쓸 수 있다.
+dense: 길이 n'의 벡터를 [v | v | 0 ...]로 두 번 복제. BSGS 행렬-벡터 곱의 입력.
+stacked: 벡터를 segment 간격으로 여러 번 복제. 다중 행 패킹 행렬-벡터 곱의 입력이며, 결과도 segment 간격으로
+흩어지고 나머지 슬롯에는 부분합(쓰레기 값)이 남는다.
+interleaved: 값들이 정해진 슬롯에 흩어져 있고 나머지 슬롯은 0 (conv2d, BSGS 결과와 마스크로 모은 stacked 결과).
+다음 행렬 층은 값의 슬롯 위치를 가중치 열에 합쳐 두므로 값을 앞쪽으로 모으는 회전이 필요 없다.
+*/
+enum class Packing
+{
+    convolution,
+    interleaved,
+    dense,
+    stacked
+};
+
+/*
+층 하나의 계획. packing은 층이 받는 표현 (square는 들어온 표현을 그대로 쓴다).
+conversion_*은 층 앞에 넣은 변환: stacked 결과를 마스크로 골라 한 암호문에 모으고 (레벨 1)
+dense/stacked 형식으로 복제한다. 회전 수는 임계 경로 기준이고 total_rotations는 병렬 암호문을 모두 센 것.
+*/
+struct LayerPlan
+{
+    LayerKind kind;
+    Packing packing;
+    std::size_t conversion_rotations;
+    std::size_t conversion_levels;
+    std::size_t rotations;
+    std::size_t total_rotations;
+    std::size_t output_ciphertexts;
+};
+
+struct NetworkPlan
+{
+    std::vector<LayerPlan> layers;
+    std::size_t critical_rotations;
+    std::size_t total_rotations;
+    std::size_t depth;
+};
+
+/*
+Helper function: 임계 경로의 회전 수가 가장 적은 표현 조합 (같으면 레벨 수, 전체 회전 수 순).
+층마다 가능한 표현(conv: convolution/dense/stacked, dense: dense/stacked)을 모두 탐색한다.
+슬롯에 들어가는 조합이 없으면 예외를 던진다.
+*/
+NetworkPlan plan_network(const std::vector<NetworkLayer> &layers, std::size_t slot_count);
+
+/*
+Helper function: 층마다 표현을 고정한 계획 (비교용). packings[i]는 i번째 층의 표현이며 square 층의 값은 무시한다.
+*/
+NetworkPlan plan_network(
+    const std::vector<NetworkLayer> &layers, const std::vector<Packing> &packings, std::size_t slot_count);
+
+/*
+NetworkPlan대로 가중치를 미리 인코딩해 두고 이미지 하나를 추론하는 런타임.
+행렬 층과 마스크는 현재 레벨의 마지막 소수를 scale로 인코딩하므로 scale은 행렬 층을 지나도 유지된다.
+여러 암호문으로 나뉜 stacked 결과는 executor의 스레드들에 나눠 계산한다.
+*/
+class LowLatencyNetwork
+{
+public:
+    LowLatencyNetwork(
+        const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+        const seal::RelinKeys &relin_keys, const std::vector<NetworkLayer> &layers, const NetworkPlan &plan);
+
+    const NetworkPlan &plan() const
+    {
+        return plan_;
+    }
+
+    std::size_t depth() const
+    {
+        return plan_.depth;
+    }
+
+    /*
+    필요한 Galois 키 step (RotationKeyPlanner::add_step에 넘긴다).
+    */
+    std::vector<int> galois_steps() const;
+
+    /*
+    클라이언트가 암호화할 슬롯 값. 첫 층의 표현으로 입력을 배치해 두므로 첫 층 앞의 변환 회전이 없다.
+    */
+    std::vector<double> encode_input(const std::vector<double> &input) const;
+
+    void infer(
+        const seal::GaloisKeys &galois_keys, const seal::Ciphertext &encrypted, std::vector<seal::Ciphertext> &destination,
+        const ParallelExecutor &executor = ParallelExecutor(1)) const;
+
+    /*
+    infer 결과를 복호화해 마지막 층의 출력으로 되돌린다.
+    */
+    std::vector<double> decrypt_output(
+        const seal::CKKSEncoder &encoder, seal::Decryptor &decryptor,
+        const std::vector<seal::Ciphertext> &encrypted) const;
+
+private:
+    // 값 i가 있는 (암호문, 슬롯)
+    using Positions = std::vector<std::pair<std::size_t, std::size_t>>;
+
+    // 층 하나를 계산하는 데 필요한 것. 쓰지 않는 가중치는 비워 둔다
+    struct Step
+    {
+        LayerKind kind;
+        Packing packing;
+        Conv2dShape conv;
+        std::size_t merge_count;
+        std::size_t dimension;
+        std::size_t copies;
+        RowPacking row_packing;
+        std::unique_ptr<WeightCache> masks;
+        std::unique_ptr<WeightCache> weights;
+        std::unique_ptr<WeightCache> bias;
+    };
+
+    const seal::SEALContext &context_;
+
+    const seal::Evaluator &evaluator_;
+
+    const seal::CKKSEncoder &encoder_;
+
+    const seal::RelinKeys &relin_keys_;
+
+    NetworkPlan plan_;
+
+    std::vector<Step> steps_;
+
+    std::size_t input_size_;
+
+    Positions output_positions_;
+};
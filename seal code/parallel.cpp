@@ -0,0 +1,68 @@
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+using namespace std;
+using namespace seal;
+
+ParallelExecutor::ParallelExecutor(size_t thread_count) : thread_count_(thread_count)
+{
+    if (thread_count_ == 0)
+    {
+        thread_count_ = max<size_t>(thread::hardware_concurrency(), 1);
+    }
+}
+
+void ParallelExecutor::run(size_t task_count, const Task &task) const
+{
+    size_t worker_count = min(thread_count_, task_count);
+    if (worker_count <= 1)
+    {
+        MemoryPoolHandle pool = MemoryManager::GetPool();
+        for (size_t index = 0; index < task_count; index++)
+        {
+            task(index, pool);
+        }
+        return;
+    }
+
+    // 작업은 공유 카운터에서 하나씩 가져가고, 예외는 작업별로 모아 두었다가 index 순서로 처리
+    atomic<size_t> next_index(0);
+    vector<exception_ptr> errors(task_count);
+    auto worker = [&]() {
+        MemoryPoolHandle pool = MemoryPoolHandle::New();
+        for (size_t index = next_index++; index < task_count; index = next_index++)
+        {
+            try
+            {
+                task(index, pool);
+            }
+            catch (...)
+            {
+                errors[index] = current_exception();
+            }
+        }
+    };
+
+    vector<thread> workers;
+    workers.reserve(worker_count - 1);
+    for (size_t t = 1; t < worker_count; t++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+
+    for (const auto &error : errors)
+    {
+        if (error)
+        {
+            rethrow_exception(error);
+        }
+    }
+}
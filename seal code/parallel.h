@@ -0,0 +1,52 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/*
+독립적인 작업(행, 출력 블록 등) 0 ~ task_count-1을 여러 스레드에 나눠 실행하는 실행기.
+각 작업 스레드는 MemoryPoolHandle::New()로 자기 전용 메모리 풀을 만들어 작업에 넘기므로
+SEAL의 임시 메모리 할당이 전역 풀의 잠금에서 경합하지 않는다.
+Evaluator, CKKSEncoder의 const 메서드와 키, WeightCache는 여러 스레드에서 공유해도 된다.
+*/
+class ParallelExecutor
+{
+public:
+    using Task = std::function<void(std::size_t index, const seal::MemoryPoolHandle &pool)>;
+
+    /*
+    thread_count가 0이면 std::thread::hardware_concurrency()개를 쓴다.
+    */
+    explicit ParallelExecutor(std::size_t thread_count = 0);
+
+    std::size_t thread_count() const
+    {
+        return thread_count_;
+    }
+
+    /*
+    task(0) ~ task(task_count-1)을 실행한다. 작업 순서는 정해져 있지 않으므로 결과는 index 위치에 써야 한다.
+    작업에서 던진 예외 중 가장 작은 index의 것을 모든 스레드가 끝난 뒤 다시 던진다.
+    스레드가 1개이거나 작업이 1개 이하이면 호출한 스레드에서 순서대로 실행한다.
+    */
+    void run(std::size_t task_count, const Task &task) const;
+
+    /*
+    run과 같지만 task의 반환값을 index 순서대로 모아 돌려준다.
+    */
+    template <typename T>
+    std::vector<T> map(
+        std::size_t task_count, const std::function<T(std::size_t, const seal::MemoryPoolHandle &)> &task) const
+    {
+        std::vector<T> results(task_count);
+        run(task_count, [&](std::size_t index, const seal::MemoryPoolHandle &pool) {
+            results[index] = task(index, pool);
+        });
+        return results;
+    }
+
+private:
+    std::size_t thread_count_;
+};
@@ -0,0 +1,159 @@
+#include "parameter_planner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+double ParameterPlan::scale() const
+{
+    return ldexp(1.0, scale_bits);
+}
+
+EncryptionParameters ParameterPlan::parameters() const
+{
+    EncryptionParameters parms(scheme_type::ckks);
+    parms.set_poly_modulus_degree(poly_modulus_degree);
+    parms.set_coeff_modulus(CoeffModulus::Create(poly_modulus_degree, coeff_modulus_bits));
+    return parms;
+}
+
+namespace
+{
+    // scale 소수와 첫 소수(= special prime)의 비트 수. 60비트를 넘으면 예외를 던진다
+    void prime_bits(int precision_bits, double value_bound, int &scale_bits, int &first_bits)
+    {
+        if (precision_bits < 1)
+        {
+            throw invalid_argument("precision_bits must be positive");
+        }
+        if (!(value_bound > 0.0))
+        {
+            throw invalid_argument("value_bound must be positive");
+        }
+
+        scale_bits = max(30, precision_bits + 20);
+        if (scale_bits > 60)
+        {
+            throw invalid_argument("precision target needs a scale above 60 bits");
+        }
+        int value_bits = static_cast<int>(ceil(log2(max(value_bound, 1.0)))) + 2;
+        first_bits = scale_bits + value_bits;
+        if (first_bits > 60)
+        {
+            throw invalid_argument("value_bound is too large for a 60-bit first prime");
+        }
+    }
+} // namespace
+
+ParameterPlan plan_parameters(const CircuitSpec &circuit)
+{
+    int scale_bits;
+    int first_bits;
+    prime_bits(circuit.precision_bits, circuit.value_bound, scale_bits, first_bits);
+
+    vector<int> bits;
+    bits.push_back(first_bits);
+    bits.insert(bits.end(), circuit.depth, scale_bits);
+    bits.push_back(first_bits);
+    int total_bits = 0;
+    for (int b : bits)
+    {
+        total_bits += b;
+    }
+
+    for (size_t poly_modulus_degree = 1024; poly_modulus_degree <= 32768; poly_modulus_degree *= 2)
+    {
+        int max_bits = CoeffModulus::MaxBitCount(poly_modulus_degree);
+        if (total_bits <= max_bits && poly_modulus_degree / 2 >= circuit.min_slots)
+        {
+            return { poly_modulus_degree, bits, scale_bits, total_bits, max_bits };
+        }
+    }
+    throw invalid_argument("circuit does not fit in 128-bit secure parameters");
+}
+
+size_t max_supported_depth(int precision_bits, double value_bound)
+{
+    int scale_bits;
+    int first_bits;
+    prime_bits(precision_bits, value_bound, scale_bits, first_bits);
+    int remaining = CoeffModulus::MaxBitCount(32768) - 2 * first_bits;
+    return remaining > 0 ? static_cast<size_t>(remaining / scale_bits) : 0;
+}
+
+namespace
+{
+    template <typename Operation>
+    double average_ms(size_t repetitions, Operation operation)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < repetitions; i++)
+        {
+            operation();
+        }
+        auto end = chrono::high_resolution_clock::now();
+        return chrono::duration<double, milli>(end - start).count() / static_cast<double>(repetitions);
+    }
+} // namespace
+
+OperationCosts measure_operation_costs(const SEALContext &context, size_t repetitions)
+{
+    if (repetitions == 0)
+    {
+        throw invalid_argument("repetitions must be positive");
+    }
+    auto context_data = context.first_context_data();
+    if (!context_data->next_context_data())
+    {
+        throw invalid_argument("parameters must allow at least one rescale");
+    }
+
+    KeyGenerator keygen(context);
+    PublicKey public_key;
+    keygen.create_public_key(public_key);
+    RelinKeys relin_keys;
+    keygen.create_relin_keys(relin_keys);
+    GaloisKeys galois_keys;
+    keygen.create_galois_keys(vector<int>{ 1 }, galois_keys);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    CKKSEncoder encoder(context);
+
+    double scale = sqrt(static_cast<double>(context_data->parms().coeff_modulus().back().value()));
+    vector<double> values(encoder.slot_count(), 0.5);
+    Plaintext plain;
+    encoder.encode(values, scale, plain);
+    Ciphertext encrypted;
+    encryptor.encrypt(plain, encrypted);
+
+    OperationCosts costs{};
+    Ciphertext result;
+    costs.multiply_relinearize_ms = average_ms(repetitions, [&]() {
+        evaluator.multiply(encrypted, encrypted, result);
+        evaluator.relinearize_inplace(result, relin_keys);
+    });
+    Ciphertext product = result;
+    costs.rescale_ms = average_ms(repetitions, [&]() { evaluator.rescale_to_next(product, result); });
+    costs.multiply_plain_ms =
+        average_ms(repetitions, [&]() { evaluator.multiply_plain(encrypted, plain, result); });
+    costs.rotate_ms =
+        average_ms(repetitions, [&]() { evaluator.rotate_vector(encrypted, 1, galois_keys, result); });
+    costs.add_ms = average_ms(repetitions, [&]() { evaluator.add(encrypted, encrypted, result); });
+    return costs;
+}
+
+double predict_latency_ms(const CircuitSpec &circuit, const ParameterPlan &plan, const OperationCosts &costs)
+{
+    // 데이터 소수는 depth + 1개에서 1개까지 줄어든다
+    double data_primes = static_cast<double>(plan.coeff_modulus_bits.size() - 1);
+    double average_fraction = (data_primes + 1.0) / (2.0 * data_primes);
+
+    double top_level_ms =
+        static_cast<double>(circuit.ciphertext_multiplications) * (costs.multiply_relinearize_ms + costs.rescale_ms) +
+        static_cast<double>(circuit.plain_multiplications) * (costs.multiply_plain_ms + costs.add_ms) +
+        static_cast<double>(circuit.rotations) * (costs.rotate_ms + costs.add_ms);
+    return top_level_ms * average_fraction;
+}
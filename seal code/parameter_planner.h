@@ -0,0 +1,78 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <cstddef>
+#include <vector>
+
+/*
+CKKS 회로 설명.
+depth는 rescale 수 (다항식이면 polynomial_depth 또는 PatersonStockmeyerSplit::depth),
+value_bound는 계산 중과 결과 값의 절댓값 상한, precision_bits는 결과에 필요한 소수점 아래 비트 수.
+min_slots는 한 암호문에 담아야 하는 값의 수.
+연산 수는 지연 시간 예측에만 쓴다.
+*/
+struct CircuitSpec
+{
+    std::size_t depth;
+    double value_bound;
+    int precision_bits;
+    std::size_t min_slots = 0;
+    std::size_t ciphertext_multiplications = 0;
+    std::size_t plain_multiplications = 0;
+    std::size_t rotations = 0;
+};
+
+/*
+plan_parameters의 결과. coeff_modulus_bits는 {첫 소수, scale_bits x depth, special prime}.
+*/
+struct ParameterPlan
+{
+    std::size_t poly_modulus_degree;
+    std::vector<int> coeff_modulus_bits;
+    int scale_bits;
+    int total_bits;
+
+    // poly_modulus_degree에서 128비트 보안을 지키는 coeff_modulus 비트 수 상한
+    int max_bits;
+
+    double scale() const;
+
+    seal::EncryptionParameters parameters() const;
+};
+
+/*
+Helper function: 회로를 128비트 보안으로 계산할 수 있는 가장 작은 poly_modulus_degree와 소수 체인.
+scale_bits = precision_bits + 20 (rescale 잡음이 scale 아래 약 20비트를 덮으므로, 30 ~ 60으로 제한),
+첫 소수는 결과 값이 들어가도록 scale_bits + ceil(log2 value_bound) + 2,
+special prime은 가장 큰 소수와 같게 둔다. 128비트 보안에 맞는 차수가 없으면 예외를 던진다.
+*/
+ParameterPlan plan_parameters(const CircuitSpec &circuit);
+
+/*
+Helper function: precision_bits, value_bound에서 plan_parameters가 128비트 보안으로 만들 수 있는 가장 큰 depth
+(poly_modulus_degree 32768). 부트스트래핑 없이 계산할 수 없는 회로를 계획 전에 걸러낼 때 쓴다.
+*/
+std::size_t max_supported_depth(int precision_bits, double value_bound);
+
+/*
+맨 위 레벨에서 측정한 연산 1회 시간 (밀리초).
+*/
+struct OperationCosts
+{
+    double multiply_relinearize_ms;
+    double rescale_ms;
+    double multiply_plain_ms;
+    double rotate_ms;
+    double add_ms;
+};
+
+/*
+Helper function: context의 파라미터로 키를 만들고 각 연산을 repetitions번 실행해 평균 시간을 잰다.
+*/
+OperationCosts measure_operation_costs(const seal::SEALContext &context, std::size_t repetitions = 5);
+
+/*
+Helper function: 측정한 연산 시간으로 회로의 지연 시간을 예측한다.
+연산 시간은 소수 개수에 비례하므로, 레벨이 내려가며 평균적으로 남는 소수 비율을 곱한다.
+*/
+double predict_latency_ms(const CircuitSpec &circuit, const ParameterPlan &plan, const OperationCosts &costs);
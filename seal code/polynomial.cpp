@@ -0,0 +1,599 @@
+#include "polynomial.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace
+{
+    /*
+    거듭제곱 트리(x^i = x^a * x^(i-a), a는 i 이하의 가장 큰 2의 거듭제곱)에서
+    다른 거듭제곱을 만드는 데 인수로 쓰이는 i. 나머지는 평문 계수 곱과 덧셈에만 쓰인다.
+    */
+    vector<bool> power_tree_factors(size_t degree)
+    {
+        vector<bool> factors(degree + 1, false);
+        size_t high_bit = 1;
+        for (size_t i = 2; i <= degree; i++)
+        {
+            if (2 * high_bit <= i)
+            {
+                high_bit *= 2;
+            }
+            if (i == high_bit)
+            {
+                factors[i / 2] = true;
+            }
+            else
+            {
+                factors[high_bit] = true;
+                factors[i - high_bit] = true;
+            }
+        }
+        return factors;
+    }
+} // namespace
+
+bool can_fold_input_scale(double bound, size_t degree)
+{
+    return static_cast<double>(degree) * log2(max(bound, 1.0)) <= 20.0;
+}
+
+size_t polynomial_depth(size_t degree)
+{
+    size_t depth = 0;
+    while ((size_t(1) << depth) < degree)
+    {
+        depth++;
+    }
+    return depth + 1;
+}
+
+vector<double> chebyshev_coefficients(const function<double(double)> &f, size_t degree, double a, double b)
+{
+    if (!(a < b))
+    {
+        throw invalid_argument("interval must satisfy a < b");
+    }
+
+    const double pi = acos(-1.0);
+    size_t n = degree + 1;
+    vector<double> values(n);
+    for (size_t j = 0; j < n; j++)
+    {
+        double node = cos(pi * (static_cast<double>(j) + 0.5) / static_cast<double>(n));
+        values[j] = f(0.5 * (b - a) * node + 0.5 * (a + b));
+    }
+
+    vector<double> coeffs(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        double sum = 0.0;
+        for (size_t j = 0; j < n; j++)
+        {
+            sum += values[j] * cos(pi * static_cast<double>(k) * (static_cast<double>(j) + 0.5) / static_cast<double>(n));
+        }
+        coeffs[k] = 2.0 * sum / static_cast<double>(n);
+    }
+    coeffs[0] /= 2.0;
+    return coeffs;
+}
+
+PatersonStockmeyerSplit choose_paterson_stockmeyer(size_t degree, bool minimize_depth)
+{
+    if (degree == 0)
+    {
+        throw invalid_argument("degree must be at least 1");
+    }
+    if (degree == 1)
+    {
+        // c0 + c1 x는 baby step 블록 하나로 끝나므로 x^2나 giant step 거듭제곱을 만들지 않는다
+        return { 2, 0, 1, 0 };
+    }
+
+    // 깊이 우선이면 2의 거듭제곱 k만, 아니면 2 <= k <= degree 전부 (k가 2의 거듭제곱이 아니어도
+    // giant step x^k, x^2k, ...와 블록 분할은 그대로 쓸 수 있다)
+    PatersonStockmeyerSplit best{ 0, 0, 0, 0 };
+    for (size_t k = 2; k <= degree; k = minimize_depth ? 2 * k : k + 1)
+    {
+        size_t giant = 0;
+        while ((k << giant) <= degree)
+        {
+            giant++;
+        }
+        size_t baby_log = 0;
+        while ((size_t(1) << baby_log) < k - 1)
+        {
+            baby_log++;
+        }
+        size_t blocks = (degree + k) / k;
+        size_t multiplications = (k - 1) + (giant - 1) + (blocks - 1);
+        // baby step 블록은 x^(k-1)까지만 쓰므로 ceil(log2(k - 1)) + 1 레벨 (k = 2이면 1)
+        size_t depth = baby_log + giant + 1;
+        bool better = minimize_depth
+                          ? (depth < best.depth ||
+                             (depth == best.depth && multiplications < best.nonscalar_multiplications))
+                          : (multiplications < best.nonscalar_multiplications ||
+                             (multiplications == best.nonscalar_multiplications && depth < best.depth));
+        if (best.baby_steps == 0 || better)
+        {
+            best = { k, giant, depth, multiplications };
+        }
+    }
+    return best;
+}
+
+PolynomialEvaluator::PolynomialEvaluator(
+    const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder, const RelinKeys &relin_keys)
+    : evaluator_(evaluator), relin_keys_(relin_keys), scales_(context, evaluator, encoder),
+      aligned_(context, evaluator, encoder, relin_keys)
+{}
+
+void PolynomialEvaluator::multiply(const Ciphertext &a, const Ciphertext &b, Ciphertext &destination) const
+{
+    aligned_.multiply(a, b, destination);
+}
+
+void PolynomialEvaluator::compute_powers(
+    const Ciphertext &encrypted_x, size_t degree, vector<Ciphertext> &powers, bool lazy_relinearization) const
+{
+    vector<bool> factors = power_tree_factors(degree);
+    vector<Ciphertext> result(degree + 1);
+    if (degree >= 1)
+    {
+        result[1] = encrypted_x;
+    }
+    size_t high_bit = 1;
+    for (size_t i = 2; i <= degree; i++)
+    {
+        if (2 * high_bit <= i)
+        {
+            high_bit *= 2;
+        }
+
+        // x^i = x^a * x^(i-a), a = i 이하의 가장 큰 2의 거듭제곱 (i가 2의 거듭제곱이면 x^(i/2)의 제곱)
+        bool relinearize = !lazy_relinearization || factors[i];
+        if (i == high_bit)
+        {
+            aligned_.multiply(result[i / 2], result[i / 2], result[i], relinearize);
+        }
+        else
+        {
+            aligned_.multiply(result[high_bit], result[i - high_bit], result[i], relinearize);
+        }
+    }
+    powers = move(result);
+}
+
+void PolynomialEvaluator::evaluate(
+    const Ciphertext &encrypted_x, const vector<double> &coeffs, Ciphertext &destination) const
+{
+    vector<Ciphertext> powers;
+    compute_powers(encrypted_x, coeffs.empty() ? 0 : coeffs.size() - 1, powers, true);
+    evaluate(powers, coeffs, encrypted_x.scale(), destination);
+}
+
+void PolynomialEvaluator::evaluate(
+    const vector<Ciphertext> &powers, const vector<double> &coeffs, double target_scale,
+    Ciphertext &destination) const
+{
+    if (coeffs.size() > powers.size())
+    {
+        throw invalid_argument("not enough powers for the polynomial degree");
+    }
+
+    // 0이 아닌 항 중 가장 낮은 레벨에 모두 맞춘다
+    parms_id_type last_parms_id = parms_id_zero;
+    size_t last_index = 0;
+    for (size_t i = 1; i < coeffs.size(); i++)
+    {
+        if (coeffs[i] == 0.0)
+        {
+            continue;
+        }
+        size_t index = scales_.chain_index(powers[i].parms_id());
+        if (last_parms_id == parms_id_zero || index < last_index)
+        {
+            last_parms_id = powers[i].parms_id();
+            last_index = index;
+        }
+    }
+    if (last_parms_id == parms_id_zero)
+    {
+        throw invalid_argument("polynomial must have a nonzero non-constant coefficient");
+    }
+    if (last_index == 0)
+    {
+        throw invalid_argument("not enough levels to evaluate the polynomial");
+    }
+    double product_scale = target_scale * scales_.rescale_prime(last_parms_id);
+
+    // 항마다 c_i * x^i의 scale이 정확히 product_scale이 되도록 계수 평문의 scale을 정한다
+    Ciphertext sum;
+    Ciphertext term;
+    bool first = true;
+    for (size_t i = 1; i < coeffs.size(); i++)
+    {
+        if (coeffs[i] == 0.0)
+        {
+            continue;
+        }
+        scales_.multiply_const_to_scale(powers[i], coeffs[i], last_parms_id, product_scale, term);
+        if (first)
+        {
+            sum = move(term);
+            first = false;
+        }
+        else
+        {
+            evaluator_.add_inplace(sum, term);
+        }
+    }
+
+    if (!coeffs.empty() && coeffs[0] != 0.0)
+    {
+        scales_.add_const_inplace(sum, coeffs[0]);
+    }
+
+    // relinearize하지 않은 거듭제곱이 섞여 있으면 합에 한 번만
+    if (sum.size() > 2)
+    {
+        evaluator_.relinearize_inplace(sum, relin_keys_);
+    }
+    scales_.rescale_to_inplace(sum, target_scale);
+    destination = move(sum);
+}
+
+void PolynomialEvaluator::evaluate_many(
+    const Ciphertext &encrypted_x, const vector<vector<double>> &coeff_sets, vector<Ciphertext> &destinations) const
+{
+    size_t degree = 0;
+    for (const auto &coeffs : coeff_sets)
+    {
+        degree = max(degree, coeffs.empty() ? size_t(0) : coeffs.size() - 1);
+    }
+
+    vector<Ciphertext> powers;
+    compute_powers(encrypted_x, degree, powers, true);
+    vector<Ciphertext> result(coeff_sets.size());
+    for (size_t j = 0; j < coeff_sets.size(); j++)
+    {
+        evaluate(powers, coeff_sets[j], encrypted_x.scale(), result[j]);
+    }
+    destinations = move(result);
+}
+
+void PolynomialEvaluator::compute_chebyshev_basis(
+    const Ciphertext &encrypted_y, size_t degree, vector<Ciphertext> &basis, bool lazy_relinearization) const
+{
+    vector<bool> factors = power_tree_factors(degree);
+    vector<Ciphertext> result(degree + 1);
+    if (degree >= 1)
+    {
+        result[1] = encrypted_y;
+    }
+
+    Ciphertext term;
+    size_t high_bit = 1;
+    for (size_t i = 2; i <= degree; i++)
+    {
+        if (2 * high_bit <= i)
+        {
+            high_bit *= 2;
+        }
+
+        // T_i = 2 T_m T_n - T_(m-n) (m = high_bit, n = i - m), i가 2의 거듭제곱이면 2 T_(i/2)^2 - 1
+        size_t m = (i == high_bit) ? i / 2 : high_bit;
+        size_t n = i - m;
+        const Ciphertext &t_m = result[m];
+        const Ciphertext &t_n = result[n];
+        size_t m_index = scales_.chain_index(t_m.parms_id());
+        size_t n_index = scales_.chain_index(t_n.parms_id());
+        parms_id_type product_parms_id = (m_index < n_index) ? t_m.parms_id() : t_n.parms_id();
+
+        Ciphertext &product = result[i];
+        if (m == n)
+        {
+            evaluator_.square(t_m, product);
+        }
+        else
+        {
+            Ciphertext aligned;
+            if (m_index > n_index)
+            {
+                evaluator_.mod_switch_to(t_m, product_parms_id, aligned);
+                evaluator_.multiply(aligned, t_n, product);
+            }
+            else
+            {
+                evaluator_.mod_switch_to(t_n, product_parms_id, aligned);
+                evaluator_.multiply(t_m, aligned, product);
+            }
+        }
+        evaluator_.add_inplace(product, product);
+
+        // 빼는 항을 곱과 같은 레벨, 같은 scale로 맞춰서 rescale 전에 더한다
+        if (m == n)
+        {
+            scales_.add_const_inplace(product, -1.0);
+        }
+        else
+        {
+            scales_.multiply_const_to_scale(result[m - n], -1.0, product_parms_id, product.scale(), term);
+            evaluator_.add_inplace(product, term);
+        }
+
+        // 빼는 항도 크기 3일 수 있으므로 더한 뒤에 relinearize한다
+        if (!lazy_relinearization || factors[i])
+        {
+            evaluator_.relinearize_inplace(product, relin_keys_);
+        }
+        evaluator_.rescale_to_next_inplace(product);
+    }
+    basis = move(result);
+}
+
+void PolynomialEvaluator::evaluate_chebyshev(
+    const Ciphertext &encrypted_x, const vector<double> &coeffs, double a, double b, Ciphertext &destination) const
+{
+    if (!(a < b))
+    {
+        throw invalid_argument("interval must satisfy a < b");
+    }
+
+    // y = alpha * x + beta. alpha는 이번 레벨의 마지막 소수를 scale로 인코딩해 rescale 후 scale을 유지한다
+    Ciphertext encrypted_y;
+    double alpha = 2.0 / (b - a);
+    double beta = -(a + b) / (b - a);
+    if (alpha == 1.0 && beta == 0.0)
+    {
+        encrypted_y = encrypted_x;
+    }
+    else
+    {
+        size_t x_index = scales_.chain_index(encrypted_x.parms_id());
+        if (x_index == 0)
+        {
+            throw invalid_argument("not enough levels to evaluate the polynomial");
+        }
+        scales_.multiply_const(encrypted_x, alpha, scales_.parms_id_at(x_index - 1), encrypted_x.scale(), encrypted_y);
+        if (beta != 0.0)
+        {
+            scales_.add_const_inplace(encrypted_y, beta);
+        }
+    }
+
+    vector<Ciphertext> basis;
+    compute_chebyshev_basis(encrypted_y, coeffs.empty() ? 0 : coeffs.size() - 1, basis, true);
+    evaluate(basis, coeffs, encrypted_x.scale(), destination);
+}
+
+/*
+coeffs[begin, begin + k * 2^giant_index) 구간의 다항식을 chain_index 레벨, 정확히 scale인 암호문으로 계산한다.
+구간 = 아래 절반 + x^(k * 2^(giant_index-1)) * 위 절반. 곱의 결과가 (chain_index, scale)이 되도록
+위 절반은 한 레벨 위(chain_index + 1)에서 scale * q / scale(giant)로 계산한다.
+계수가 상수뿐이면 암호문 없이 상수를 돌려준다.
+*/
+PolynomialEvaluator::PartialResult PolynomialEvaluator::evaluate_block(
+    const vector<Ciphertext> &baby_powers, const vector<Ciphertext> &giant_powers, const vector<double> &coeffs,
+    size_t begin, size_t giant_index, size_t chain_index, double scale, const Ciphertext *multiplier) const
+{
+    size_t k = baby_powers.size() - 1;
+    size_t size = k << giant_index;
+    size_t end = min(begin + size, coeffs.size());
+    PartialResult result{ false, Ciphertext(), (begin < coeffs.size() && !multiplier) ? coeffs[begin] : 0.0 };
+    if (begin >= coeffs.size())
+    {
+        return result;
+    }
+
+    parms_id_type upper_parms_id = scales_.parms_id_at(chain_index + 1);
+    double upper_prime = scales_.rescale_prime(upper_parms_id);
+
+    Ciphertext aligned;
+    if (giant_index == 0)
+    {
+        // baby step 다항식: sum c_i x^i (i < k). 모든 항을 scale * q로 맞춘 뒤 한 번만 rescale
+        // multiplier가 있으면 c_0 * m + sum (c_i * m) * x^i
+        Ciphertext term;
+        for (size_t i = multiplier ? 0 : 1; i < end - begin; i++)
+        {
+            double coeff = coeffs[begin + i];
+            if (coeff == 0.0)
+            {
+                continue;
+            }
+            if (!multiplier)
+            {
+                scales_.multiply_const_to_scale(baby_powers[i], coeff, upper_parms_id, scale * upper_prime, term);
+            }
+            else if (i == 0)
+            {
+                scales_.multiply_const(*multiplier, coeff, upper_parms_id, scale * upper_prime, term);
+            }
+            else
+            {
+                Ciphertext power;
+                evaluator_.mod_switch_to(baby_powers[i], upper_parms_id, power);
+                Ciphertext weighted;
+                scales_.multiply_const(
+                    *multiplier, coeff, upper_parms_id, scale * upper_prime / power.scale(), weighted);
+                evaluator_.multiply(weighted, power, term);
+            }
+            if (!result.encrypted)
+            {
+                result.ciphertext = move(term);
+                result.encrypted = true;
+            }
+            else
+            {
+                evaluator_.add_inplace(result.ciphertext, term);
+            }
+        }
+        if (result.encrypted)
+        {
+            if (result.constant != 0.0)
+            {
+                scales_.add_const_inplace(result.ciphertext, result.constant);
+            }
+            if (result.ciphertext.size() > 2)
+            {
+                evaluator_.relinearize_inplace(result.ciphertext, relin_keys_);
+            }
+            scales_.rescale_to_inplace(result.ciphertext, scale);
+        }
+        return result;
+    }
+
+    // 위 절반 * x^half
+    size_t half = size / 2;
+    evaluator_.mod_switch_to(giant_powers[giant_index - 1], upper_parms_id, aligned);
+    double high_scale = scale * upper_prime / aligned.scale();
+    PartialResult high = evaluate_block(
+        baby_powers, giant_powers, coeffs, begin + half, giant_index - 1, chain_index + 1, high_scale, multiplier);
+    PartialResult low =
+        evaluate_block(baby_powers, giant_powers, coeffs, begin, giant_index - 1, chain_index, scale, multiplier);
+
+    Ciphertext product;
+    bool has_product = true;
+    if (high.encrypted)
+    {
+        evaluator_.multiply(high.ciphertext, aligned, product);
+        evaluator_.relinearize_inplace(product, relin_keys_);
+        scales_.rescale_to_inplace(product, scale);
+    }
+    else if (high.constant != 0.0)
+    {
+        scales_.multiply_const(aligned, high.constant, scales_.parms_id_at(chain_index), scale, product);
+    }
+    else
+    {
+        has_product = false;
+    }
+
+    if (!has_product)
+    {
+        return low;
+    }
+    result.encrypted = true;
+    result.ciphertext = move(product);
+    if (low.encrypted)
+    {
+        evaluator_.add_inplace(result.ciphertext, low.ciphertext);
+    }
+    else if (low.constant != 0.0)
+    {
+        scales_.add_const_inplace(result.ciphertext, low.constant);
+    }
+    return result;
+}
+
+void PolynomialEvaluator::evaluate_paterson_stockmeyer(
+    const Ciphertext &encrypted_x, const vector<double> &coeffs, Ciphertext &destination) const
+{
+    if (coeffs.size() < 2)
+    {
+        throw invalid_argument("polynomial must have a nonzero non-constant coefficient");
+    }
+    PatersonStockmeyerBasis basis;
+    compute_paterson_stockmeyer_basis(encrypted_x, coeffs.size() - 1, basis);
+    evaluate_paterson_stockmeyer(basis, coeffs, destination);
+}
+
+void PolynomialEvaluator::compute_paterson_stockmeyer_basis(
+    const Ciphertext &encrypted_x, size_t degree, PatersonStockmeyerBasis &basis) const
+{
+    compute_paterson_stockmeyer_basis(encrypted_x, choose_paterson_stockmeyer(degree), basis);
+}
+
+void PolynomialEvaluator::compute_paterson_stockmeyer_basis(
+    const Ciphertext &encrypted_x, const PatersonStockmeyerSplit &split, PatersonStockmeyerBasis &basis) const
+{
+    size_t x_index = scales_.chain_index(encrypted_x.parms_id());
+    if (x_index < split.depth)
+    {
+        throw invalid_argument("not enough levels to evaluate the polynomial");
+    }
+
+    // baby step x^1 ~ x^k (거듭제곱 트리), giant step x^k, x^2k, x^4k, ... (제곱)
+    PatersonStockmeyerBasis result{ split, {}, vector<Ciphertext>(split.giant_steps), x_index - split.depth,
+                                    encrypted_x.scale() };
+    // giant step이 없으면(차수 1) x^k는 쓰지 않으므로 x^(k-1)까지만 만든다
+    compute_powers(encrypted_x, split.giant_steps ? split.baby_steps : split.baby_steps - 1, result.baby_powers);
+    result.baby_powers.resize(split.baby_steps + 1);
+    for (size_t j = 0; j < split.giant_steps; j++)
+    {
+        if (j == 0)
+        {
+            result.giant_powers[j] = result.baby_powers[split.baby_steps];
+        }
+        else
+        {
+            multiply(result.giant_powers[j - 1], result.giant_powers[j - 1], result.giant_powers[j]);
+        }
+    }
+    basis = move(result);
+}
+
+void PolynomialEvaluator::evaluate_paterson_stockmeyer(
+    const PatersonStockmeyerBasis &basis, const vector<double> &coeffs, Ciphertext &destination) const
+{
+    if (coeffs.size() > (basis.split.baby_steps << basis.split.giant_steps))
+    {
+        throw invalid_argument("polynomial degree is larger than the basis");
+    }
+    PartialResult result = evaluate_block(
+        basis.baby_powers, basis.giant_powers, coeffs, 0, basis.split.giant_steps, basis.chain_index, basis.scale);
+    if (!result.encrypted)
+    {
+        throw invalid_argument("polynomial must have a nonzero non-constant coefficient");
+    }
+    destination = move(result.ciphertext);
+}
+
+void PolynomialEvaluator::evaluate_paterson_stockmeyer(
+    const PatersonStockmeyerBasis &basis, const vector<double> &coeffs, const Ciphertext &multiplier,
+    Ciphertext &destination) const
+{
+    if (coeffs.size() > (basis.split.baby_steps << basis.split.giant_steps))
+    {
+        throw invalid_argument("polynomial degree is larger than the basis");
+    }
+    if (scales_.chain_index(multiplier.parms_id()) <= basis.chain_index + basis.split.giant_steps + 1)
+    {
+        throw invalid_argument("multiplier must be above the highest baby step block");
+    }
+    PartialResult result = evaluate_block(
+        basis.baby_powers, basis.giant_powers, coeffs, 0, basis.split.giant_steps, basis.chain_index, basis.scale,
+        &multiplier);
+    if (!result.encrypted)
+    {
+        throw invalid_argument("polynomial must have a nonzero coefficient");
+    }
+    destination = move(result.ciphertext);
+}
+
+void PolynomialEvaluator::evaluate_paterson_stockmeyer_many(
+    const Ciphertext &encrypted_x, const vector<vector<double>> &coeff_sets, vector<Ciphertext> &destinations) const
+{
+    size_t degree = 0;
+    for (const auto &coeffs : coeff_sets)
+    {
+        degree = max(degree, coeffs.empty() ? size_t(0) : coeffs.size() - 1);
+    }
+    if (degree == 0)
+    {
+        throw invalid_argument("polynomial must have a nonzero non-constant coefficient");
+    }
+
+    PatersonStockmeyerBasis basis;
+    compute_paterson_stockmeyer_basis(encrypted_x, degree, basis);
+    vector<Ciphertext> result(coeff_sets.size());
+    for (size_t j = 0; j < coeff_sets.size(); j++)
+    {
+        evaluate_paterson_stockmeyer(basis, coeff_sets[j], result[j]);
+    }
+    destinations = move(result);
+}
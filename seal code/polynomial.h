@@ -0,0 +1,220 @@
+#pragma once
+
+#include "aligned_evaluator.h"
+#include "scale_manager.h"
+#include "seal/seal.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/*
+Helper function: 차수 degree인 다항식을 PolynomialEvaluator로 평가할 때 쓰는 레벨(rescale) 수.
+거듭제곱 트리 ceil(log2 degree) + 계수 곱 1.
+*/
+std::size_t polynomial_depth(std::size_t degree);
+
+/*
+Helper function: |x| <= bound인 입력을 x / bound로 바꾸는 대신 차수 degree 다항식의 계수에 bound^-i를 합쳐도 되는지.
+합치면 레벨이 들지 않지만 계수 평문의 반올림 오차가 x^i와 곱해져 bound^i / scale로 커지므로,
+bound^degree <= 2^20일 때만 합친다. 아니면 ScaleManager::multiply_const로 한 레벨을 써서 먼저 나눈다.
+*/
+bool can_fold_input_scale(double bound, std::size_t degree);
+
+/*
+Helper function: [a, b]에서 f를 근사하는 차수 degree의 Chebyshev 계수 (체비쇼프 노드 degree + 1개에서 보간).
+f(x) ~ sum_k coeffs[k] * T_k((2x - a - b) / (b - a)). 서버에 올리기 전에 평문으로 한 번 계산해 둔다.
+*/
+std::vector<double> chebyshev_coefficients(
+    const std::function<double(double)> &f, std::size_t degree, double a, double b);
+
+/*
+Paterson-Stockmeyer 분할. baby step 거듭제곱 x^1 ~ x^k (k = baby_steps)와
+giant step 거듭제곱 x^k, x^2k, x^4k, ..., x^(2^(giant_steps-1) k)만 만들고 (k * 2^giant_steps > degree),
+p(x)를 차수 k 미만의 작은 다항식(계수 곱만 필요)들과 giant step 거듭제곱의 곱으로 재귀적으로 나눈다.
+*/
+struct PatersonStockmeyerSplit
+{
+    std::size_t baby_steps;
+    std::size_t giant_steps;
+    std::size_t depth;
+    std::size_t nonscalar_multiplications;
+};
+
+/*
+Helper function: 2 <= k <= degree 중 암호문끼리의 곱 (k-1) + (giant_steps-1) + (블록 수 - 1)이
+가장 적은 k를 고른다. 같으면 깊이가 작은 쪽. 곱셈 수는 약 2*sqrt(degree)이고 깊이는 ceil(log2(degree + 1)) + 1.
+giant step을 x^k, x^2k, x^3k, ...로 두면 곱셈이 약 sqrt(2*degree)까지 줄지만 깊이가 degree / k에 비례해
+늘어나므로, 여기서는 제곱으로 만든 x^(k 2^j)와 이분 분할로 깊이를 로그로 유지하는 대신 곱셈을 그만큼 더 쓴다.
+minimize_depth이면 반대로 깊이가 가장 작은 k를 2의 거듭제곱 중에서 고른다 (같으면 곱셈 수가 적은 쪽).
+k = 2이면 baby step 블록이 c0 + c1 x뿐이라 깊이가 ceil(log2(degree + 1))로 최소다.
+degree = 1이면 baby step 블록 하나(k = 2, giant_steps = 0)로 곱셈 없이 평가한다.
+*/
+PatersonStockmeyerSplit choose_paterson_stockmeyer(std::size_t degree, bool minimize_depth = false);
+
+/*
+Paterson-Stockmeyer 평가에 쓰는 x의 거듭제곱 (baby step x^1 ~ x^k, giant step x^k, x^2k, ...).
+한 번 만들어 두고 같은 x에 대한 여러 다항식에 다시 쓴다. degree 이하의 다항식이면 모두 평가할 수 있고,
+결과는 모두 같은 레벨(chain_index), 같은 scale이므로 바로 더하거나 곱할 수 있다.
+*/
+struct PatersonStockmeyerBasis
+{
+    PatersonStockmeyerSplit split;
+    std::vector<seal::Ciphertext> baby_powers;
+    std::vector<seal::Ciphertext> giant_powers;
+    std::size_t chain_index;
+    double scale;
+};
+
+/*
+암호화된 x에 대한 다항식 평가기.
+x^i는 x^(i-1) * x가 아니라 x^a * x^(i-a) (a는 i보다 작은 가장 큰 2의 거듭제곱)로 만들어서
+x^1 ~ x^d 전체가 ceil(log2 d) 레벨 안에 만들어진다. 레벨이 다른 두 암호문을 곱하거나 더할 때는
+높은 쪽을 mod_switch_to_inplace로 낮은 쪽 레벨에 맞춘다.
+*/
+class PolynomialEvaluator
+{
+public:
+    PolynomialEvaluator(
+        const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder,
+        const seal::RelinKeys &relin_keys);
+
+    /*
+    powers[i] = x^i (1 <= i <= degree). powers[0]은 비워 둔다.
+    x^i는 ceil(log2 i)번 rescale된 레벨에 있다.
+    lazy_relinearization이 true이면 다른 거듭제곱의 인수로 쓰이지 않는 x^i (d=63이면 x^33 ~ x^63)는
+    relinearize하지 않고 크기 3으로 둔다. evaluate가 계수 항을 모두 더한 뒤 한 번만 relinearize하므로
+    key switch가 그만큼 줄어든다. 이렇게 만든 거듭제곱은 평문 곱과 덧셈에만 써야 한다.
+    */
+    void compute_powers(
+        const seal::Ciphertext &encrypted_x, std::size_t degree, std::vector<seal::Ciphertext> &powers,
+        bool lazy_relinearization = false) const;
+
+    /*
+    sum_i coeffs[i] * x^i. 모든 거듭제곱을 가장 낮은 레벨에 맞추고, 계수 평문을 항마다
+    (x.scale * 다음 rescale 소수) / x^i.scale 로 인코딩해서 모든 항의 scale을 정확히 같게 만든 뒤
+    더하고 한 번만 rescale한다. 결과의 scale은 encrypted_x의 scale과 같고 polynomial_depth(degree) 레벨을 쓴다.
+    상수가 아닌 계수가 하나 이상 0이 아니어야 한다.
+    */
+    void evaluate(
+        const seal::Ciphertext &encrypted_x, const std::vector<double> &coeffs, seal::Ciphertext &destination) const;
+
+    /*
+    이미 만들어 둔 거듭제곱(compute_powers)으로 평가한다. 같은 x에 여러 다항식을 평가할 때 쓴다.
+    target_scale은 결과 scale. 크기 3인 거듭제곱이 있으면 rescale 직전의 합을 한 번만 relinearize한다.
+    */
+    void evaluate(
+        const std::vector<seal::Ciphertext> &powers, const std::vector<double> &coeffs, double target_scale,
+        seal::Ciphertext &destination) const;
+
+    /*
+    basis[k] = T_k(y) (1 <= k <= degree, Chebyshev 다항식). basis[0]은 비워 둔다.
+    T_2n = 2 T_n^2 - 1, T_(m+n) = 2 T_m T_n - T_(m-n) (m은 가장 큰 2의 거듭제곱)로 만들어서
+    T_k도 x^k와 같이 ceil(log2 k) 레벨에 있다. 빼는 항은 곱과 같은 레벨, 같은 scale로 맞춘 뒤
+    rescale 전에 더하므로 T_k 하나에 rescale은 한 번이다.
+    lazy_relinearization은 compute_powers와 같다.
+    */
+    void compute_chebyshev_basis(
+        const seal::Ciphertext &encrypted_y, std::size_t degree, std::vector<seal::Ciphertext> &basis,
+        bool lazy_relinearization = false) const;
+
+    /*
+    같은 x에 여러 다항식을 평가한다 (구간별 근사, 함수와 도함수 등). 거듭제곱은 가장 높은 차수까지
+    한 번만 만들고, 결과 destinations[j]는 coeff_sets[j]의 값이다.
+    결과의 레벨은 다항식마다 다를 수 있다 (AlignedEvaluator로 맞춰서 더한다).
+    */
+    void evaluate_many(
+        const seal::Ciphertext &encrypted_x, const std::vector<std::vector<double>> &coeff_sets,
+        std::vector<seal::Ciphertext> &destinations) const;
+
+    /*
+    [a, b] 위의 x에 대해 sum_k coeffs[k] * T_k((2x - a - b) / (b - a))를 계산한다 (coeffs는 chebyshev_coefficients).
+    구간 변환은 첫 레벨에서 평문 곱 한 번과 평문 덧셈으로 하고 ([-1, 1]이면 생략),
+    이후는 evaluate와 같이 모든 항의 scale을 정확히 맞춰 더한다. 결과의 scale은 encrypted_x의 scale과 같다.
+    레벨은 polynomial_depth(degree) + 1 ([-1, 1]이면 polynomial_depth(degree)).
+    */
+    void evaluate_chebyshev(
+        const seal::Ciphertext &encrypted_x, const std::vector<double> &coeffs, double a, double b,
+        seal::Ciphertext &destination) const;
+
+    /*
+    Paterson-Stockmeyer 방식 평가. 암호문끼리의 곱이 choose_paterson_stockmeyer(degree)의
+    nonscalar_multiplications번뿐이고 나머지는 평문 계수 곱과 덧셈이다.
+    메모리에는 baby step, giant step 거듭제곱만 둔다 (d개 전부가 아님).
+    각 부분 결과의 레벨과 scale을 위에서부터 정해 두므로 모든 덧셈에서 scale이 정확히 같고,
+    결과의 scale은 encrypted_x의 scale과 같다.
+    */
+    void evaluate_paterson_stockmeyer(
+        const seal::Ciphertext &encrypted_x, const std::vector<double> &coeffs, seal::Ciphertext &destination) const;
+
+    /*
+    차수 degree까지의 Paterson-Stockmeyer 거듭제곱을 만든다.
+    */
+    void compute_paterson_stockmeyer_basis(
+        const seal::Ciphertext &encrypted_x, std::size_t degree, PatersonStockmeyerBasis &basis) const;
+
+    /*
+    정해 둔 분할(choose_paterson_stockmeyer(degree, true) 등)로 거듭제곱을 만든다.
+    */
+    void compute_paterson_stockmeyer_basis(
+        const seal::Ciphertext &encrypted_x, const PatersonStockmeyerSplit &split,
+        PatersonStockmeyerBasis &basis) const;
+
+    /*
+    만들어 둔 거듭제곱으로 평가한다. coeffs의 차수는 basis를 만든 degree 이하여야 하고,
+    결과는 basis.chain_index 레벨, 정확히 basis.scale이다.
+    */
+    void evaluate_paterson_stockmeyer(
+        const PatersonStockmeyerBasis &basis, const std::vector<double> &coeffs, seal::Ciphertext &destination) const;
+
+    /*
+    multiplier * p(x)를 p(x)와 같은 레벨, 정확히 basis.scale로 평가한다. baby step 블록의 상수 곱 c_i * x^i를
+    (c_i * multiplier) * x^i 암호문 곱으로 바꾸므로 multiplier를 곱하는 데 레벨이 들지 않는다.
+    대신 블록마다 암호문 곱이 baby step 수만큼 늘고, multiplier는 가장 높은 블록보다 한 레벨 이상 위에 있어야 한다.
+    */
+    void evaluate_paterson_stockmeyer(
+        const PatersonStockmeyerBasis &basis, const std::vector<double> &coeffs, const seal::Ciphertext &multiplier,
+        seal::Ciphertext &destination) const;
+
+    /*
+    같은 x에 여러 다항식을 Paterson-Stockmeyer 방식으로 평가한다. baby step, giant step 거듭제곱은
+    가장 높은 차수에 맞춰 한 번만 만들고 모든 다항식이 나눠 쓰므로, 다항식을 하나 더할 때 드는 암호문 곱은
+    블록 수 - 1번뿐이다.
+    */
+    void evaluate_paterson_stockmeyer_many(
+        const seal::Ciphertext &encrypted_x, const std::vector<std::vector<double>> &coeff_sets,
+        std::vector<seal::Ciphertext> &destinations) const;
+
+    /*
+    두 암호문을 같은 레벨로 맞춘 뒤 곱하고 relinearize, rescale한다 (AlignedEvaluator::multiply).
+    */
+    void multiply(const seal::Ciphertext &a, const seal::Ciphertext &b, seal::Ciphertext &destination) const;
+
+    /*
+    거듭제곱을 만들 때 넣은 mod switch 수 등을 확인할 때 쓴다.
+    */
+    const AlignedEvaluator &aligned() const
+    {
+        return aligned_;
+    }
+
+private:
+    struct PartialResult
+    {
+        bool encrypted;
+        seal::Ciphertext ciphertext;
+        double constant;
+    };
+
+    PartialResult evaluate_block(
+        const std::vector<seal::Ciphertext> &baby_powers, const std::vector<seal::Ciphertext> &giant_powers,
+        const std::vector<double> &coeffs, std::size_t begin, std::size_t giant_index, std::size_t chain_index,
+        double scale, const seal::Ciphertext *multiplier = nullptr) const;
+
+    const seal::Evaluator &evaluator_;
+
+    const seal::RelinKeys &relin_keys_;
+
+    ScaleManager scales_;
+
+    AlignedEvaluator aligned_;
+};
@@ -0,0 +1,162 @@
+#include "scale_manager.h"
+#include "seal/util/polyarithsmallmod.h"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace
+{
+    // 정수 coeff (|coeff| < 2^63)의 modulus 나머지
+    uint64_t reduce_constant(double coeff, const Modulus &modulus)
+    {
+        uint64_t magnitude = static_cast<uint64_t>(fabs(coeff)) % modulus.value();
+        return (coeff < 0 && magnitude != 0) ? modulus.value() - magnitude : magnitude;
+    }
+
+    bool fits_in_int64(double coeff)
+    {
+        return fabs(coeff) < ldexp(1.0, 63);
+    }
+} // namespace
+
+ScaleManager::ScaleManager(const SEALContext &context, const Evaluator &evaluator, const CKKSEncoder &encoder)
+    : context_(context), evaluator_(evaluator), encoder_(encoder)
+{}
+
+size_t ScaleManager::chain_index(parms_id_type parms_id) const
+{
+    auto context_data = context_.get_context_data(parms_id);
+    if (!context_data)
+    {
+        throw invalid_argument("parms_id is not valid for the encryption parameters");
+    }
+    return context_data->chain_index();
+}
+
+parms_id_type ScaleManager::parms_id_at(size_t chain_index) const
+{
+    for (auto context_data = context_.first_context_data(); context_data;
+         context_data = context_data->next_context_data())
+    {
+        if (context_data->chain_index() == chain_index)
+        {
+            return context_data->parms_id();
+        }
+    }
+    throw invalid_argument("chain index is not in the modulus chain");
+}
+
+double ScaleManager::rescale_prime(parms_id_type parms_id) const
+{
+    auto context_data = context_.get_context_data(parms_id);
+    if (!context_data)
+    {
+        throw invalid_argument("parms_id is not valid for the encryption parameters");
+    }
+    return static_cast<double>(context_data->parms().coeff_modulus().back().value());
+}
+
+void ScaleManager::multiply_const_to_scale(
+    const Ciphertext &encrypted, double value, parms_id_type parms_id, double scale, Ciphertext &destination,
+    MemoryPoolHandle pool) const
+{
+    if (value == 0.0)
+    {
+        throw invalid_argument("value must be nonzero");
+    }
+    evaluator_.mod_switch_to(encrypted, parms_id, destination, pool);
+    multiply_scalar_inplace(destination, value, scale / destination.scale());
+    settle_scale(destination, scale);
+}
+
+void ScaleManager::multiply_const(
+    const Ciphertext &encrypted, double value, parms_id_type target_parms_id, double target_scale,
+    Ciphertext &destination, MemoryPoolHandle pool) const
+{
+    size_t target_index = chain_index(target_parms_id);
+    if (chain_index(encrypted.parms_id()) <= target_index)
+    {
+        throw invalid_argument("not enough levels to reach the target level");
+    }
+    parms_id_type upper_parms_id = parms_id_at(target_index + 1);
+    multiply_const_to_scale(
+        encrypted, value, upper_parms_id, target_scale * rescale_prime(upper_parms_id), destination, pool);
+    rescale_to_inplace(destination, target_scale, pool);
+}
+
+void ScaleManager::multiply_scalar_inplace(Ciphertext &encrypted, double value, double scale) const
+{
+    auto context_data = context_.get_context_data(encrypted.parms_id());
+    if (!context_data)
+    {
+        throw invalid_argument("encrypted is not valid for encryption parameters");
+    }
+    double coeff = round(value * scale);
+    if (log2(encrypted.scale() * scale) + 1 >= context_data->total_coeff_modulus_bit_count())
+    {
+        throw invalid_argument("scale out of bounds");
+    }
+    if (!fits_in_int64(coeff))
+    {
+        Plaintext plain;
+        encoder_.encode(value, encrypted.parms_id(), scale, plain);
+        evaluator_.multiply_plain_inplace(encrypted, plain);
+        return;
+    }
+
+    const auto &coeff_modulus = context_data->parms().coeff_modulus();
+    size_t coeff_count = encrypted.poly_modulus_degree();
+    for (size_t j = 0; j < coeff_modulus.size(); j++)
+    {
+        uint64_t scalar = reduce_constant(coeff, coeff_modulus[j]);
+        for (size_t i = 0; i < encrypted.size(); i++)
+        {
+            uint64_t *poly = encrypted.data(i) + j * coeff_count;
+            util::multiply_poly_scalar_coeffmod(poly, coeff_count, scalar, coeff_modulus[j], poly);
+        }
+    }
+    encrypted.scale() *= scale;
+}
+
+void ScaleManager::add_const_inplace(Ciphertext &encrypted, double value) const
+{
+    auto context_data = context_.get_context_data(encrypted.parms_id());
+    if (!context_data)
+    {
+        throw invalid_argument("encrypted is not valid for encryption parameters");
+    }
+    double coeff = round(value * encrypted.scale());
+    if (!fits_in_int64(coeff))
+    {
+        Plaintext plain;
+        encoder_.encode(value, encrypted.parms_id(), encrypted.scale(), plain);
+        evaluator_.add_plain_inplace(encrypted, plain);
+        return;
+    }
+
+    const auto &coeff_modulus = context_data->parms().coeff_modulus();
+    size_t coeff_count = encrypted.poly_modulus_degree();
+    for (size_t j = 0; j < coeff_modulus.size(); j++)
+    {
+        uint64_t *poly = encrypted.data(0) + j * coeff_count;
+        util::add_poly_scalar_coeffmod(poly, coeff_count, reduce_constant(coeff, coeff_modulus[j]), coeff_modulus[j], poly);
+    }
+}
+
+void ScaleManager::rescale_to_inplace(Ciphertext &encrypted, double exact_scale, MemoryPoolHandle pool) const
+{
+    evaluator_.rescale_to_next_inplace(encrypted, pool);
+    settle_scale(encrypted, exact_scale);
+}
+
+void ScaleManager::settle_scale(Ciphertext &encrypted, double exact_scale) const
+{
+    if (fabs(encrypted.scale() - exact_scale) > exact_scale * 1e-12)
+    {
+        throw invalid_argument("ciphertext scale does not match the tracked scale");
+    }
+    encrypted.scale() = exact_scale;
+}
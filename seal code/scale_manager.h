@@ -0,0 +1,75 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <cstddef>
+
+/*
+CKKS 암호문의 scale을 정확히 추적한다.
+rescale은 scale을 그 레벨의 마지막 소수 q로 나누므로 결과는 2^40이 아니라 2^80 / q 같은 값이 된다.
+scale() = pow(2.0, 40)으로 덮어쓰면 그 비율(q / 2^40)만큼 값이 틀어지므로, 대신 평문 계수를
+(목표 scale * q) / 암호문 scale로 인코딩해서 곱하고 rescale한 결과가 정확히 목표 scale이 되게 한다.
+이렇게 만든 항들은 scale이 같으므로 바로 더할 수 있다.
+*/
+class ScaleManager
+{
+public:
+    ScaleManager(const seal::SEALContext &context, const seal::Evaluator &evaluator, const seal::CKKSEncoder &encoder);
+
+    std::size_t chain_index(seal::parms_id_type parms_id) const;
+
+    seal::parms_id_type parms_id_at(std::size_t chain_index) const;
+
+    /*
+    parms_id 레벨에서 rescale할 때 나누는 소수 (coeff_modulus의 마지막 소수).
+    */
+    double rescale_prime(seal::parms_id_type parms_id) const;
+
+    /*
+    encrypted를 parms_id 레벨로 내리고 value를 곱한다 (rescale하지 않음). 결과의 scale은 정확히 scale.
+    같은 레벨, 같은 scale로 만든 항들을 더한 뒤 한 번만 rescale할 때 쓴다. value는 0이 아니어야 한다.
+    */
+    void multiply_const_to_scale(
+        const seal::Ciphertext &encrypted, double value, seal::parms_id_type parms_id, double scale,
+        seal::Ciphertext &destination, seal::MemoryPoolHandle pool = seal::MemoryManager::GetPool()) const;
+
+    /*
+    encrypted * value를 target_parms_id 레벨, 정확히 target_scale인 암호문으로 만든다.
+    target_parms_id의 한 레벨 위에서 곱하고 rescale하므로 encrypted는 그 레벨 이상이어야 한다.
+    */
+    void multiply_const(
+        const seal::Ciphertext &encrypted, double value, seal::parms_id_type target_parms_id, double target_scale,
+        seal::Ciphertext &destination, seal::MemoryPoolHandle pool = seal::MemoryManager::GetPool()) const;
+
+    /*
+    encrypted에 실수 상수 value를 곱한다. 결과의 scale은 encrypted.scale() * scale이고 레벨은 그대로다.
+    round(value * scale)의 소수별 나머지를 암호문 다항식 계수에 바로 곱하므로 평문을 만들지 않는다
+    (encode, mod_switch, Plaintext 할당 없음). |round(value * scale)| >= 2^63이면 encode 경로로 돌아간다.
+    */
+    void multiply_scalar_inplace(seal::Ciphertext &encrypted, double value, double scale) const;
+
+    /*
+    value를 encrypted와 같은 scale로 더한다. NTT 형태에서 상수 다항식은 모든 계수가 같으므로
+    첫 번째 다항식의 계수에 소수별 나머지를 바로 더한다.
+    */
+    void add_const_inplace(seal::Ciphertext &encrypted, double value) const;
+
+    /*
+    rescale한 뒤 scale이 exact_scale인지 확인한다 (settle_scale).
+    */
+    void rescale_to_inplace(
+        seal::Ciphertext &encrypted, double exact_scale,
+        seal::MemoryPoolHandle pool = seal::MemoryManager::GetPool()) const;
+
+    /*
+    scale의 곱과 나눗셈에서 생기는 부동소수점 반올림 오차(몇 ulp)만 exact_scale로 정리한다.
+    상대 차이가 반올림 오차보다 크면 계산 순서가 잘못된 것이므로 덮어쓰지 않고 예외를 던진다.
+    */
+    void settle_scale(seal::Ciphertext &encrypted, double exact_scale) const;
+
+private:
+    const seal::SEALContext &context_;
+
+    const seal::Evaluator &evaluator_;
+
+    const seal::CKKSEncoder &encoder_;
+};
@@ -0,0 +1,62 @@
+#include "weight_cache.h"
+
+using namespace std;
+using namespace seal;
+
+WeightCache::WeightCache(const CKKSEncoder &encoder, vector<vector<double>> values)
+    : encoder_(encoder), values_(move(values))
+{}
+
+WeightCache::WeightCache(const CKKSEncoder &encoder, const vector<double> &scalars) : encoder_(encoder), scalar_(true)
+{
+    for (double scalar : scalars)
+    {
+        values_.push_back({ scalar });
+    }
+}
+
+const vector<Plaintext> &WeightCache::get(parms_id_type parms_id, double scale) const
+{
+    lock_guard<mutex> lock(mutex_);
+    auto key = make_pair(parms_id, scale);
+    auto it = cache_.find(key);
+    if (it != cache_.end())
+    {
+        return it->second;
+    }
+
+    vector<Plaintext> encoded(values_.size());
+    for (size_t i = 0; i < values_.size(); i++)
+    {
+        if (scalar_)
+        {
+            encoder_.encode(values_[i][0], parms_id, scale, encoded[i]);
+        }
+        else
+        {
+            encoder_.encode(values_[i], parms_id, scale, encoded[i]);
+        }
+    }
+    return cache_.emplace(key, move(encoded)).first->second;
+}
+
+void WeightCache::prepare(parms_id_type parms_id, double scale) const
+{
+    get(parms_id, scale);
+}
+
+void WeightCache::prepare_rescale_levels(const SEALContext &context) const
+{
+    for (auto context_data = context.first_context_data(); context_data && context_data->next_context_data();
+         context_data = context_data->next_context_data())
+    {
+        double prime = static_cast<double>(context_data->parms().coeff_modulus().back().value());
+        prepare(context_data->parms_id(), prime);
+    }
+}
+
+size_t WeightCache::encoded_count() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return cache_.size() * values_.size();
+}
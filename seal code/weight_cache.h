@@ -0,0 +1,65 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+고정된 가중치(행렬 대각선, 패킹된 행, 다항식 계수 등)를 미리 인코딩해 두는 평문 저장소.
+encode는 IFFT + NTT 전체를 수행하므로 요청마다 반복하지 않도록
+(parms_id, scale)마다 한 번만 NTT 형태 Plaintext로 인코딩하고 이후에는 캐시된 것을 돌려준다.
+여러 스레드에서 동시에 get을 호출해도 된다.
+*/
+class WeightCache
+{
+public:
+    WeightCache(const seal::CKKSEncoder &encoder, std::vector<std::vector<double>> values);
+
+    /*
+    스칼라 가중치 저장소. i번째 평문은 모든 슬롯이 scalars[i]인 상수로 인코딩하며 values(i)는 길이 1이다.
+    슬롯마다 다른 입력을 담은 배치 암호문에 같은 가중치를 곱할 때 쓴다.
+    */
+    WeightCache(const seal::CKKSEncoder &encoder, const std::vector<double> &scalars);
+
+    std::size_t size() const
+    {
+        return values_.size();
+    }
+
+    const std::vector<double> &values(std::size_t index) const
+    {
+        return values_[index];
+    }
+
+    /*
+    (parms_id, scale)에 해당하는 평문들을 돌려준다. 처음 요청될 때 한 번만 인코딩한다.
+    */
+    const std::vector<seal::Plaintext> &get(seal::parms_id_type parms_id, double scale) const;
+
+    /*
+    서비스 시작 시 미리 인코딩해 둔다.
+    */
+    void prepare(seal::parms_id_type parms_id, double scale) const;
+
+    /*
+    rescale이 가능한 모든 레벨에서, 그 레벨의 rescale로 빠질 소수를 scale로 미리 인코딩한다.
+    행렬-벡터 곱 커널은 이 scale을 써서 rescale 후에도 입력 scale을 유지한다.
+    */
+    void prepare_rescale_levels(const seal::SEALContext &context) const;
+
+    std::size_t encoded_count() const;
+
+private:
+    const seal::CKKSEncoder &encoder_;
+
+    std::vector<std::vector<double>> values_;
+
+    bool scalar_ = false;
+
+    mutable std::map<std::pair<seal::parms_id_type, double>, std::vector<seal::Plaintext>> cache_;
+
+    mutable std::mutex mutex_;
+};